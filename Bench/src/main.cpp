@@ -0,0 +1,229 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "protocol.hpp"
+#include "serialization.hpp"
+#include "ReliableChannel.hpp"
+#include "transport.hpp"
+#include "globals.hpp"
+
+// how many times every benchmark runs its operation
+const int ITERATIONS = 1000000;
+
+// keeps the compiler from optimizing away the benchmarked work
+volatile int sink = 0;
+
+/**
+ * @brief Times an operation and prints how long it takes on average.
+ * @param name The name of the benchmark.
+ * @param operation The operation, returns a value that depends on its work.
+ */
+void benchmark(const std::string& name, const std::function<int()>& operation)
+{
+	// warm up the caches and the branch predictor
+	for (int i = 0; i < ITERATIONS / 10; i++)
+		sink = sink + operation();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++)
+		sink = sink + operation();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << elapsed.count() / ITERATIONS << " ns/op" << std::endl;
+}
+
+/**
+ * @brief Benchmarks encoding and decoding the packets the server sends the most.
+ */
+void benchmarkCodec()
+{
+	protocol::Packet player;
+	player.type = protocol::PacketType::UPDATE_PLAYER;
+	player.index = 1025;
+	player.position = { 12.3f, 45.6f };
+	player.direction = 1.234f;
+	player.sequence = 123456;
+	player.tick = 98765;
+
+	protocol::Packet input;
+	input.type = protocol::PacketType::PLAYER_INPUT;
+	input.index = 1025;
+	input.direction = 4.321f;
+	input.sequence = 123456;
+	input.input = { 1, -1 };
+
+	protocol::Packet reliable;
+	reliable.type = protocol::PacketType::RELIABLE;
+	reliable.index = 1025;
+	reliable.payload.assign(200, 'x');
+
+	for (auto& [name, packet] : { std::pair{ "UPDATE_PLAYER", player }, { "PLAYER_INPUT", input }, { "RELIABLE (200 bytes)", reliable } })
+	{
+		std::vector<char> data = protocol::encodePacket(packet);
+		std::cout << name << ": " << data.size() << " bytes" << std::endl;
+
+		benchmark(std::string("encode ") + name, [&]() { return (int)protocol::encodePacket(packet).size(); });
+		benchmark(std::string("decode ") + name, [&]()
+			{
+				protocol::Packet decoded;
+				protocol::decodePacket(data.data(), (int)data.size(), decoded);
+				return decoded.index;
+			});
+	}
+
+	// the primitives every packet and message is made of
+	benchmark("write 8 varints", []()
+		{
+			serialization::Writer writer;
+			for (int shift = 0; shift < 32; shift += 4)
+				writer.writeVarint(1u << shift);
+			return (int)writer.getData().size();
+		});
+
+	serialization::Writer varints;
+	for (int shift = 0; shift < 32; shift += 4)
+		varints.writeVarint(1u << shift);
+	const std::vector<char>& varintData = varints.getData();
+
+	benchmark("read 8 varints", [&]()
+		{
+			serialization::Reader reader(varintData.data(), (int)varintData.size());
+			int sum = 0;
+			while (!reader.atEnd())
+				sum += reader.readVarint();
+			return sum;
+		});
+}
+
+/**
+ * @brief Sends reliable messages from a server to a client over a loopback network that loses, delays and reorders packets,
+ * and checks that every message arrives exactly once, and the ordered ones in order.
+ * The channels run on the network's clock, so every run sends and loses exactly the same packets.
+ * @return Whether every message arrived correctly.
+ */
+bool loopbackReliableDelivery()
+{
+	const int MESSAGES = 600;
+	const int MESSAGES_PER_TICK = 12;
+	const int MAX_TICKS = 60 * globals::SERVER_TICKS;
+
+	sockets::LinkConditions conditions;
+	conditions.latency = 0.05;
+	conditions.jitter = 0.02;
+	conditions.loss = 0.2;
+	conditions.reorder = 0.1;
+
+	sockets::LoopbackNetwork network(conditions, 1234);
+	sockets::LoopbackTransport serverTransport(network, { "10.0.0.1", globals::UDP_PORT });
+	sockets::LoopbackTransport clientTransport(network, { "10.0.0.2", 0 });
+
+	ReliableChannel::clock::time_point start = ReliableChannel::clock::now();
+	auto now = [&]()
+		{
+			return start + std::chrono::duration_cast<ReliableChannel::clock::duration>(std::chrono::duration<double>(network.getTime()));
+		};
+
+	ReliableChannel server(start), client(start);
+
+	std::vector<int> received(MESSAGES, 0);
+	int lastOrdered = -1;
+	bool inOrder = true;
+	int packetsSent = 0;
+	int receivedCount = 0;
+	int tick = 0;
+
+	// sends a side's packet, if it has one, to the other side
+	auto write = [&](ReliableChannel& channel, const sockets::Transport& from, const sockets::Transport& to)
+		{
+			protocol::Packet packet;
+			packet.type = protocol::PacketType::RELIABLE;
+			packet.payload = channel.writePacket(now());
+			if (packet.payload.empty())
+				return;
+
+			protocol::sendPacket(from, to.getSocketName(), packet);
+			packetsSent++;
+		};
+
+	// reads every packet that arrived to a side
+	auto read = [&](ReliableChannel& channel, const sockets::Transport& transport)
+		{
+			for (protocol::Packet packet = protocol::receivePacket(transport); packet.type != protocol::PacketType::NO_PACKET; packet = protocol::receivePacket(transport))
+				channel.readPacket(packet.payload, now());
+		};
+
+	for (; tick < MAX_TICKS && receivedCount < MESSAGES; tick++)
+	{
+		// every fourth message is unordered, and the sizes vary so they don't all fit in one packet
+		for (int i = tick * MESSAGES_PER_TICK; i < (tick + 1) * MESSAGES_PER_TICK && i < MESSAGES; i++)
+		{
+			serialization::Writer message;
+			message.writeVarint(i);
+			message.writeBytes(std::vector<char>(i % 200, 'x'));
+			server.send(message.getData(), i % 4 != 0);
+		}
+
+		write(server, serverTransport, clientTransport);
+		write(client, clientTransport, serverTransport);
+
+		network.advance(1.0 / globals::SERVER_TICKS);
+
+		read(server, serverTransport);
+		read(client, clientTransport);
+
+		ReliableChannel::Message message;
+		while (client.receive(message))
+		{
+			serialization::Reader reader(message.data(), (int)message.size());
+			int id = reader.readVarint();
+			if (id < 0 || id >= MESSAGES)
+				continue;
+
+			if (received[id]++ == 0)
+				receivedCount++;
+
+			if (id % 4 != 0)
+			{
+				inOrder = inOrder && id > lastOrdered;
+				lastOrdered = id;
+			}
+		}
+	}
+
+	bool exactlyOnce = std::all_of(received.begin(), received.end(), [](int count) { return count == 1; });
+
+	std::cout << "loopback reliable delivery: " << receivedCount << "/" << MESSAGES << " messages in "
+		<< tick / (float)globals::SERVER_TICKS << " simulated seconds, " << packetsSent << " packets, "
+		<< "measured loss " << server.getStats().loss << ", rtt " << server.getStats().rtt * 1000 << "ms" << std::endl;
+
+	if (!exactlyOnce)
+		std::cout << "FAILED: a message was lost or received twice" << std::endl;
+	if (!inOrder)
+		std::cout << "FAILED: ordered messages were received out of order" << std::endl;
+
+	return exactlyOnce && inOrder;
+}
+
+/**
+ * @brief Runs the benchmarks and scenarios, all of them or the one named in the arguments.
+ * Usage: Bench [codec|loopback]
+ * @return 0 if every scenario passed, 1 if one failed.
+ */
+int main(int argc, char* argv[])
+{
+	std::string which = argc > 1 ? argv[1] : "";
+	bool passed = true;
+
+	if (which.empty() || which == "codec")
+		benchmarkCodec();
+
+	if (which.empty() || which == "loopback")
+		passed = loopbackReliableDelivery() && passed;
+
+	return passed ? 0 : 1;
+}
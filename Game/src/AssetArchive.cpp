@@ -0,0 +1,150 @@
+#include "AssetArchive.hpp"
+#include <fstream>
+#include <cstring>
+#include <Windows.h>
+#include "serialization.hpp"
+#include "logging.hpp"
+
+AssetArchive::AssetArchive() : file(INVALID_HANDLE_VALUE), mapping(NULL), view(nullptr), size(0) {}
+
+AssetArchive::~AssetArchive()
+{
+	close();
+}
+
+bool AssetArchive::open(const std::string& path)
+{
+	close();
+
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL)
+		view = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (view == nullptr || !readIndex())
+	{
+		logging::warning("Invalid asset archive", { { "path", path } });
+		close();
+		return false;
+	}
+
+	logging::info("Opened asset archive", { { "path", path }, { "assets", std::to_string(entries.size()) } });
+	return true;
+}
+
+void AssetArchive::close()
+{
+	if (view != nullptr)
+		UnmapViewOfFile(view);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	view = nullptr;
+	size = 0;
+	entries.clear();
+}
+
+bool AssetArchive::isOpen() const
+{
+	return view != nullptr;
+}
+
+std::string_view AssetArchive::get(const std::string& name) const
+{
+	auto entry = entries.find(name);
+	if (entry == entries.end())
+		return {};
+	return { view + entry->second.offset, entry->second.size };
+}
+
+bool AssetArchive::pack(const std::vector<std::string>& files, const std::string& path)
+{
+	std::vector<std::vector<char>> contents;
+	for (const std::string& filename : files)
+	{
+		std::ifstream input(filename, std::ios::binary);
+		if (!input)
+		{
+			logging::error("Can't read asset", { { "path", filename } });
+			return false;
+		}
+		contents.emplace_back(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	}
+
+	// the offsets are from the end of the index, so the index doesn't depend on its own size
+	serialization::Writer index;
+	for (char c : MAGIC)
+		index.writeByte(c);
+	index.writeVarint(VERSION);
+	index.writeVarint((uint32_t)files.size());
+	uint32_t offset = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		index.writeString(files[i]);
+		index.writeVarint(offset);
+		index.writeVarint((uint32_t)contents[i].size());
+		offset += (uint32_t)contents[i].size();
+	}
+
+	std::ofstream output(path, std::ios::binary);
+	uint32_t indexSize = (uint32_t)index.getData().size();
+	output.write((const char*)&indexSize, sizeof(indexSize));
+	output.write(index.getData().data(), indexSize);
+	for (const std::vector<char>& content : contents)
+		output.write(content.data(), content.size());
+
+	if (!output)
+	{
+		logging::error("Can't write asset archive", { { "path", path } });
+		return false;
+	}
+
+	logging::info("Packed assets", { { "path", path }, { "assets", std::to_string(files.size()) } });
+	return true;
+}
+
+bool AssetArchive::readIndex()
+{
+	uint32_t indexSize = 0;
+	if (size < sizeof(indexSize))
+		return false;
+	std::memcpy(&indexSize, view, sizeof(indexSize));
+	if (indexSize > size - sizeof(indexSize))
+		return false;
+
+	size_t dataStart = sizeof(indexSize) + indexSize;
+	serialization::Reader reader(view + sizeof(indexSize), (int)indexSize);
+	for (char c : MAGIC)
+		if (reader.readByte() != (uint8_t)c)
+			return false;
+	if (reader.readVarint() != VERSION)
+		return false;
+
+	uint32_t count = reader.readVarint();
+	for (uint32_t i = 0; i < count && !reader.failed(); i++)
+	{
+		std::string name = reader.readString();
+		Entry entry{ dataStart + reader.readVarint(), 0 };
+		entry.size = reader.readVarint();
+		if (entry.offset + entry.size > size)
+			return false;
+		entries[name] = entry;
+	}
+
+	return !reader.failed();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @brief A packed asset file, mapped into memory instead of read. The file starts with an index of the assets' names,
+ * offsets and sizes, so an asset is found without reading the others and its bytes are used where they are mapped.
+ */
+class AssetArchive
+{
+public:
+	// the first bytes of every archive
+	inline static const std::string MAGIC = "CCPK";
+	inline static const int VERSION = 1;
+
+	/**
+	 * @brief Creates a new AssetArchive object. Nothing is mapped before open is called.
+	 */
+	AssetArchive();
+
+	/**
+	 * @brief Unmaps the file.
+	 */
+	~AssetArchive();
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	/**
+	 * @brief Maps an archive and reads its index.
+	 * @param path The path of the archive.
+	 * @return Whether the archive was opened, false if it doesn't exist or isn't a valid archive.
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * @brief Unmaps the file. The bytes returned by get can't be used after it.
+	 */
+	void close();
+
+	/**
+	 * @brief Checks if an archive is open.
+	 * @return Whether an archive is open.
+	 */
+	bool isOpen() const;
+
+	/**
+	 * @brief Finds an asset. Can be called from any thread.
+	 * @param name The name of the asset (the path it was packed from).
+	 * @return The bytes of the asset, where they are mapped, or empty if the archive doesn't have it.
+	 */
+	std::string_view get(const std::string& name) const;
+
+	/**
+	 * @brief Packs files into a new archive.
+	 * @param files The paths of the files, which are also their names in the archive.
+	 * @param path The path of the archive.
+	 * @return Whether the archive was written.
+	 */
+	static bool pack(const std::vector<std::string>& files, const std::string& path);
+
+private:
+	struct Entry
+	{
+		size_t offset;
+		size_t size;
+	};
+
+	/**
+	 * @brief Reads the index at the start of the mapped file.
+	 * @return Whether the index is valid.
+	 */
+	bool readIndex();
+
+	// HANDLEs of the file and its mapping
+	void* file;
+	void* mapping;
+
+	const char* view;
+	size_t size;
+
+	std::unordered_map<std::string, Entry> entries;
+};
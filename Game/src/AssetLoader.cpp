@@ -0,0 +1,163 @@
+#include "AssetLoader.hpp"
+#include <fstream>
+#include <chrono>
+#include "Mipmaps.hpp"
+#include "logging.hpp"
+
+AssetLoader::AssetLoader(TextureManager& textures, sf::Font& font)
+	: textures(textures), font(font), running(true), decoded(QUEUE_CAPACITY), queued(0), uploaded(0)
+{
+	// one core is left for the render thread
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int count = cores > 1 ? cores - 1 : 1;
+	if (count > MAX_WORKERS)
+		count = MAX_WORKERS;
+
+	for (unsigned int i = 0; i < count; i++)
+		workers.push_back(std::thread(&AssetLoader::work, this));
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+bool AssetLoader::openArchive(const std::string& path)
+{
+	return archive.open(path);
+}
+
+void AssetLoader::loadTexture(const std::string& id, const std::string& filename, bool repeated, bool mipmapped)
+{
+	Asset asset;
+	asset.type = AssetType::TEXTURE;
+	asset.id = id;
+	asset.filename = filename;
+	asset.repeated = repeated;
+	asset.mipmapped = mipmapped;
+	queue(std::move(asset));
+}
+
+void AssetLoader::loadFont(const std::string& filename)
+{
+	Asset asset;
+	asset.type = AssetType::FONT;
+	asset.filename = filename;
+	queue(std::move(asset));
+}
+
+void AssetLoader::update(float budgetSeconds)
+{
+	auto start = std::chrono::steady_clock::now();
+	do
+	{
+		std::optional<Asset> asset = decoded.pop();
+		if (!asset)
+			return;
+
+		upload(*asset);
+		uploaded++;
+	} while (std::chrono::steady_clock::now() - start < std::chrono::duration<float>(budgetSeconds));
+}
+
+bool AssetLoader::isDone() const
+{
+	return uploaded == queued;
+}
+
+float AssetLoader::getProgress() const
+{
+	return queued == 0 ? 1.0f : (float)uploaded / queued;
+}
+
+void AssetLoader::work()
+{
+	while (true)
+	{
+		Asset asset;
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [this]() { return !running || !pending.empty(); });
+			if (!running)
+				return;
+
+			asset = std::move(pending.front());
+			pending.pop_front();
+		}
+
+		decode(asset);
+
+		// the render thread makes room
+		while (!decoded.push(std::move(asset)))
+		{
+			std::lock_guard lock(mutex);
+			if (!running)
+				return;
+			std::this_thread::yield();
+		}
+	}
+}
+
+void AssetLoader::decode(Asset& asset) const
+{
+	std::string_view packed = archive.get(asset.filename);
+
+	if (asset.type == AssetType::TEXTURE)
+	{
+		asset.image = std::make_unique<sf::Image>();
+		asset.failed = packed.empty() ? !asset.image->loadFromFile(asset.filename) : !asset.image->loadFromMemory(packed.data(), packed.size());
+		if (asset.mipmapped && !asset.failed)
+			asset.levels = buildMipChain(*asset.image);
+		return;
+	}
+
+	// a packed font is read where it's mapped
+	if (!packed.empty())
+		return;
+
+	std::ifstream file(asset.filename, std::ios::binary);
+	asset.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	asset.failed = asset.bytes.empty();
+}
+
+void AssetLoader::upload(Asset& asset)
+{
+	if (asset.failed)
+		throw std::exception(("ERROR: Can't load " + asset.filename).c_str());
+
+	if (asset.type == AssetType::TEXTURE)
+	{
+		if (asset.mipmapped)
+			textures.addTexture(asset.id, *asset.image, asset.levels, asset.repeated);
+		else
+			textures.addTexture(asset.id, *asset.image, asset.repeated);
+		return;
+	}
+
+	std::string_view packed = archive.get(asset.filename);
+	if (packed.empty())
+	{
+		fontBytes = std::move(asset.bytes);
+		packed = { fontBytes.data(), fontBytes.size() };
+	}
+
+	if (!font.loadFromMemory(packed.data(), packed.size()))
+		throw std::exception(("ERROR: Can't load " + asset.filename).c_str());
+}
+
+void AssetLoader::queue(Asset asset)
+{
+	queued++;
+	{
+		std::lock_guard lock(mutex);
+		pending.push_back(std::move(asset));
+	}
+	condition.notify_one();
+}
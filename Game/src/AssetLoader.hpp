@@ -0,0 +1,153 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "SFML/Graphics.hpp"
+#include "MpscQueue.hpp"
+#include "AssetArchive.hpp"
+#include "TextureManager.hpp"
+
+/**
+ * @brief Loads textures and fonts without blocking the window. Images are read and decoded by a pool of worker threads,
+ * and the render thread uploads them to the GPU in update, only as many as fit in its time budget every frame.
+ * The assets come from the packed archive if one is open, otherwise from their files.
+ */
+class AssetLoader
+{
+public:
+	// how many decoded assets can wait for the render thread, the workers wait while it's full
+	inline static const int QUEUE_CAPACITY = 64;
+
+	// the most worker threads, decoding is limited by the disk after a few
+	inline static const unsigned int MAX_WORKERS = 4;
+
+	/**
+	 * @brief Creates a new AssetLoader object and starts its workers.
+	 * @param textures Where the textures are added.
+	 * @param font The font that is loaded.
+	 */
+	AssetLoader(TextureManager& textures, sf::Font& font);
+
+	/**
+	 * @brief Stops the workers. Assets that weren't uploaded are dropped.
+	 */
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	/**
+	 * @brief Loads the assets from a packed archive instead of their files. Must be called before loading.
+	 * @param path The path of the archive.
+	 * @return Whether the archive was opened.
+	 */
+	bool openArchive(const std::string& path);
+
+	/**
+	 * @brief Starts loading a texture.
+	 * @param id The ID of the texture.
+	 * @param filename The filename of the texture, also its name in the archive.
+	 * @param repeated Whether the texture repeats outside its size.
+	 * @param mipmapped Whether the texture gets a mip chain, which is built by the workers too.
+	 */
+	void loadTexture(const std::string& id, const std::string& filename, bool repeated = false, bool mipmapped = false);
+
+	/**
+	 * @brief Starts loading the font.
+	 * @param filename The filename of the font, also its name in the archive.
+	 */
+	void loadFont(const std::string& filename);
+
+	/**
+	 * @brief Uploads the assets that were decoded, until the budget is spent (at least one every call).
+	 * Must be called from the thread that draws. Throws std::exception if an asset couldn't be loaded.
+	 * @param budgetSeconds How many seconds the uploads can take.
+	 */
+	void update(float budgetSeconds);
+
+	/**
+	 * @brief Checks if all the assets were loaded.
+	 * @return Whether nothing is left to load.
+	 */
+	bool isDone() const;
+
+	/**
+	 * @brief Returns how much of the assets were loaded.
+	 * @return The loaded part, between 0 and 1.
+	 */
+	float getProgress() const;
+
+private:
+	enum class AssetType
+	{
+		TEXTURE,
+		FONT
+	};
+
+	/**
+	 * @brief An asset to load, and after a worker decoded it, its data.
+	 */
+	struct Asset
+	{
+		AssetType type = AssetType::TEXTURE;
+		std::string id;
+		std::string filename;
+		bool repeated = false;
+		bool mipmapped = false;
+		bool failed = false;
+		// the decoded texture (sf::Image can't be moved)
+		std::unique_ptr<sf::Image> image;
+		// its mip chain after level 0, if it's mipmapped
+		std::vector<sf::Image> levels;
+		// the font file, when it's not in the archive
+		std::vector<char> bytes;
+	};
+
+	/**
+	 * @brief Decodes assets until the loader stops. Runs on the worker threads.
+	 */
+	void work();
+
+	/**
+	 * @brief Reads and decodes an asset. Runs on the worker threads.
+	 * @param asset The asset.
+	 */
+	void decode(Asset& asset) const;
+
+	/**
+	 * @brief Uploads a decoded asset. Runs on the render thread.
+	 * @param asset The asset.
+	 */
+	void upload(Asset& asset);
+
+	/**
+	 * @brief Queues an asset for the workers.
+	 * @param asset The asset.
+	 */
+	void queue(Asset asset);
+
+	TextureManager& textures;
+	sf::Font& font;
+	// the font reads from these bytes for as long as it's used
+	std::vector<char> fontBytes;
+
+	AssetArchive archive;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	// assets waiting for a worker, protected by mutex
+	std::deque<Asset> pending;
+	bool running;
+
+	MpscQueue<Asset> decoded;
+
+	int queued;
+	int uploaded;
+
+	std::vector<std::thread> workers;
+};
@@ -0,0 +1,76 @@
+#include "InterpolationBuffer.hpp"
+#include "util.hpp"
+#include <algorithm>
+
+InterpolationBuffer::InterpolationBuffer() : snapshots(), head(0), count(0) {}
+
+void InterpolationBuffer::push(int tick, sf::Vector2f position)
+{
+	if (count > 0 && tick <= newestTick())
+		return;
+
+	snapshots[head] = { tick, position };
+	head = (head + 1) % SIZE;
+	count = std::min(count + 1, SIZE);
+}
+
+sf::Vector2f InterpolationBuffer::sample(float tick) const
+{
+	if (count == 0)
+		return { 0, 0 };
+
+	const Snapshot& newest = at(0);
+
+	// newer than everything we have, keep moving in the last direction
+	if (tick >= newest.tick)
+	{
+		if (count == 1)
+			return newest.position;
+
+		const Snapshot& previous = at(1);
+		sf::Vector2f velocity = (newest.position - previous.position) / (float)(newest.tick - previous.tick);
+		float ticksAhead = std::min(tick - newest.tick, (float)MAX_EXTRAPOLATION_TICKS);
+		return newest.position + velocity * ticksAhead;
+	}
+
+	// find the two snapshots around the tick
+	for (int age = 1; age < count; age++)
+	{
+		const Snapshot& older = at(age);
+		if (older.tick <= tick)
+		{
+			const Snapshot& newer = at(age - 1);
+			float t = (tick - older.tick) / (newer.tick - older.tick);
+			return older.position + (newer.position - older.position) * t;
+		}
+	}
+
+	// older than everything we have
+	return at(count - 1).position;
+}
+
+void InterpolationBuffer::clear()
+{
+	head = 0;
+	count = 0;
+}
+
+bool InterpolationBuffer::empty() const
+{
+	return count == 0;
+}
+
+int InterpolationBuffer::oldestTick() const
+{
+	return at(count - 1).tick;
+}
+
+int InterpolationBuffer::newestTick() const
+{
+	return at(0).tick;
+}
+
+const InterpolationBuffer::Snapshot& InterpolationBuffer::at(int age) const
+{
+	return snapshots[(head - 1 - age + SIZE) % SIZE];
+}
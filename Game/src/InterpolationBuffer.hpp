@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief A ring buffer of an entity's positions from the server, used to render it a bit in the past.
+ */
+class InterpolationBuffer
+{
+public:
+	/**
+	 * @brief Creates a new empty InterpolationBuffer object.
+	 */
+	InterpolationBuffer();
+
+	/**
+	 * @brief Adds a position. Positions older than the newest one are ignored.
+	 * @param tick The server tick of the position.
+	 * @param position The position.
+	 */
+	void push(int tick, sf::Vector2f position);
+
+	/**
+	 * @brief Gets the position at a point in server time.
+	 * Interpolates between the positions around the tick, and extrapolates (for a limited time) if the tick is newer than all of them.
+	 * @param tick The server tick (can be between ticks).
+	 * @return The position. If the buffer is empty, returns (0, 0).
+	 */
+	sf::Vector2f sample(float tick) const;
+
+	/**
+	 * @brief Removes all positions.
+	 */
+	void clear();
+
+	/**
+	 * @brief Checks if the buffer is empty.
+	 * @return Whether the buffer is empty.
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Returns the tick of the oldest position.
+	 * @return The tick of the oldest position.
+	 */
+	int oldestTick() const;
+
+	/**
+	 * @brief Returns the tick of the newest position.
+	 * @return The tick of the newest position.
+	 */
+	int newestTick() const;
+
+	inline static const int SIZE = 32;
+
+	// how many ticks to keep moving an entity after its last position
+	inline static const int MAX_EXTRAPOLATION_TICKS = 15;
+
+private:
+	struct Snapshot
+	{
+		int tick;
+		sf::Vector2f position;
+	};
+
+	/**
+	 * @brief Gets a snapshot by its age.
+	 * @param age 0 is the newest snapshot, count - 1 is the oldest.
+	 * @return The snapshot.
+	 */
+	const Snapshot& at(int age) const;
+
+	std::array<Snapshot, SIZE> snapshots;
+
+	// where the next snapshot is written
+	int head;
+	int count;
+};
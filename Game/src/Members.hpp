@@ -3,14 +3,16 @@
 #include "SFML/Graphics.hpp"
 #include "states/StateManager.hpp"
 #include "TextureManager.hpp"
+#include "AssetLoader.hpp"
+#include "RenderScale.hpp"
 
 // A struct to manage all global members between states.
 struct Members
 {
 	/**
-	 * @brief Creates a new Members object with the sockets initialized.
+	 * @brief Creates a new Members object. The sockets are created when connecting to the server.
 	 */
-	Members() : tcpSocket(sockets::Protocol::TCP), udpSocket(sockets::Protocol::UDP), playerIndex(0) {}
+	Members() : assets(textures, font), playerIndex(0), spectating(false) {}
 
 	// The SFML window.
 	sf::RenderWindow window;
@@ -24,6 +26,12 @@ struct Members
 	// The texture manager.
 	TextureManager textures;
 
+	// Loads the textures and the font in the background.
+	AssetLoader assets;
+
+	// The resolution of the 3D view, kept between games.
+	RenderScale renderScale;
+
 	// Socket for TCP communication.
 	sockets::Socket tcpSocket;
 
@@ -31,5 +39,8 @@ struct Members
 	sockets::Socket udpSocket;
 
 	// Player index in the server.
-	char playerIndex;
+	int playerIndex;
+
+	// Whether the game is watched instead of played (connected to the spectator port of a server or relay).
+	bool spectating;
 };
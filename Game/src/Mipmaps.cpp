@@ -0,0 +1,55 @@
+#include "Mipmaps.hpp"
+#include <cmath>
+
+std::vector<sf::Image> buildMipChain(const sf::Image& image)
+{
+	std::vector<sf::Image> levels;
+	sf::Vector2u size = image.getSize();
+	if (size.x == 0 || size.y == 0)
+		return levels;
+
+	// sf::Image can't be moved, so all the levels are created in place
+	int count = 0;
+	for (sf::Vector2u levelSize = size; levelSize.x > 1 || levelSize.y > 1; count++)
+		levelSize = { levelSize.x > 1 ? levelSize.x / 2 : 1, levelSize.y > 1 ? levelSize.y / 2 : 1 };
+	levels.resize(count);
+
+	std::vector<sf::Uint8> pixels;
+	for (int level = 0; level < count; level++)
+	{
+		const sf::Image& source = level == 0 ? image : levels[level - 1];
+		sf::Vector2u sourceSize = source.getSize();
+		sf::Vector2u levelSize = { sourceSize.x > 1 ? sourceSize.x / 2 : 1, sourceSize.y > 1 ? sourceSize.y / 2 : 1 };
+		const sf::Uint8* sourcePixels = source.getPixelsPtr();
+
+		pixels.resize(levelSize.x * levelSize.y * 4);
+		for (unsigned int y = 0; y < levelSize.y; y++)
+		{
+			// an odd row or column at the end is left out, like the size
+			unsigned int y0 = y * sourceSize.y / levelSize.y, y1 = sourceSize.y > 1 ? y0 + 1 : y0;
+			for (unsigned int x = 0; x < levelSize.x; x++)
+			{
+				unsigned int x0 = x * sourceSize.x / levelSize.x, x1 = sourceSize.x > 1 ? x0 + 1 : x0;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					unsigned int sum = sourcePixels[(y0 * sourceSize.x + x0) * 4 + channel] + sourcePixels[(y0 * sourceSize.x + x1) * 4 + channel]
+						+ sourcePixels[(y1 * sourceSize.x + x0) * 4 + channel] + sourcePixels[(y1 * sourceSize.x + x1) * 4 + channel];
+					pixels[(y * levelSize.x + x) * 4 + channel] = (sf::Uint8)((sum + 2) / 4);
+				}
+			}
+		}
+
+		levels[level].create(levelSize.x, levelSize.y, pixels.data());
+	}
+
+	return levels;
+}
+
+int chooseMipLevel(float texelsPerPixel, int levelCount)
+{
+	if (texelsPerPixel <= 1)
+		return 0;
+
+	int level = (int)std::log2(texelsPerPixel);
+	return level < levelCount - 1 ? level : levelCount - 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include "SFML/Graphics.hpp"
+
+/**
+ * @brief Builds the smaller levels of an image's mip chain, each half the size of the previous one (rounded down, at least 1),
+ * down to 1x1. Every pixel is the average of the 2x2 pixels it covers in the previous level.
+ * @param image The image, level 0 of the chain.
+ * @return The levels after level 0.
+ */
+std::vector<sf::Image> buildMipChain(const sf::Image& image);
+
+/**
+ * @brief Chooses the mip level to sample, so that one texel of the level covers about one pixel of the screen.
+ * @param texelsPerPixel How many texels of level 0 one pixel covers.
+ * @param levelCount How many levels the texture has, including level 0.
+ * @return The level.
+ */
+int chooseMipLevel(float texelsPerPixel, int levelCount);
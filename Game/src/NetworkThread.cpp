@@ -0,0 +1,126 @@
+#include "NetworkThread.hpp"
+#include "messages.hpp"
+#include "logging.hpp"
+
+NetworkThread::NetworkThread() : index(-1), events(QUEUE_CAPACITY), running(false) {}
+
+NetworkThread::~NetworkThread()
+{
+	stop();
+}
+
+void NetworkThread::start(sockets::Socket tcpSocket, sockets::Socket udpSocket, sockets::Address serverAddress, int index)
+{
+	this->tcpSocket = tcpSocket;
+	this->udpSocket = udpSocket;
+	this->serverAddress = serverAddress;
+	this->index = index;
+
+	// wait for packets instead of polling for them
+	this->udpSocket.setBlocking(true);
+	this->udpSocket.setTimeout(RECEIVE_TIMEOUT);
+
+	running = true;
+	thread = std::thread(&NetworkThread::run, this);
+}
+
+void NetworkThread::send(const protocol::Packet& packet) const
+{
+	// sending and receiving on one socket from two threads is safe
+	protocol::sendPacket(udpSocket, serverAddress, packet);
+}
+
+bool NetworkThread::poll(Event& event)
+{
+	std::optional<Event> next = events.pop();
+	if (!next)
+		return false;
+
+	event = std::move(*next);
+	return true;
+}
+
+void NetworkThread::close()
+{
+	stop();
+
+	try
+	{
+		messages::send(tcpSocket, messages::Close{});
+		tcpSocket.setBlocking(true);
+		messages::receive(tcpSocket); // to stop closing with RST
+	}
+	catch (sockets::exception& err)
+	{
+		logging::warning("Can't close connection", { { "error", err.what() } });
+	}
+
+	tcpSocket.close();
+	udpSocket.close();
+}
+
+void NetworkThread::run()
+{
+	while (running)
+	{
+		// the render thread made room
+		while (!overflow.empty() && events.push(overflow.front()))
+			overflow.pop_front();
+
+		protocol::Packet packet = protocol::receivePacket(udpSocket);
+		auto now = std::chrono::steady_clock::now();
+
+		if (packet.type == protocol::PacketType::RELIABLE)
+		{
+			if (channel.readPacket(packet.payload))
+			{
+				Event event;
+				event.type = EventType::STATS;
+				event.time = now;
+				event.stats = channel.getStats();
+				pushEvent(std::move(event));
+
+				ReliableChannel::Message message;
+				while (channel.receive(message))
+					pushEvent({ EventType::MESSAGE, now, {}, message, {} });
+			}
+		}
+		else if (packet.type != protocol::PacketType::NO_PACKET)
+			pushEvent({ EventType::PACKET, now, std::move(packet), {}, {} });
+
+		// acks for what was received, when they are due
+		protocol::Packet reliablePacket;
+		reliablePacket.payload = channel.writePacket();
+		if (!reliablePacket.payload.empty())
+		{
+			reliablePacket.type = protocol::PacketType::RELIABLE;
+			reliablePacket.index = index;
+			try
+			{
+				send(reliablePacket);
+			}
+			catch (sockets::exception& err)
+			{
+				logging::error("UDP error", { { "error", err.what() } });
+			}
+		}
+	}
+}
+
+void NetworkThread::pushEvent(Event event)
+{
+	if (overflow.empty() && events.push(event))
+		return;
+
+	// messages are never dropped, the channel already acked them
+	if (event.type == EventType::MESSAGE || (int)overflow.size() < QUEUE_CAPACITY)
+		overflow.push_back(std::move(event));
+}
+
+void NetworkThread::stop()
+{
+	if (!running.exchange(false))
+		return;
+
+	thread.join();
+}
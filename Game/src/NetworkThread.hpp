@@ -0,0 +1,113 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include "sockets.hpp"
+#include "protocol.hpp"
+#include "ReliableChannel.hpp"
+#include "MpscQueue.hpp"
+
+/**
+ * @brief Receives from the server on its own thread, so a slow frame doesn't delay packets and a burst of packets doesn't delay a frame.
+ * It owns the client's sockets during the game: it decodes the packets, runs the reliable channel (and its acks),
+ * and passes everything to the render thread as timestamped events on a lock-free queue.
+ */
+class NetworkThread
+{
+public:
+	enum class EventType
+	{
+		PACKET,		// a packet that isn't RELIABLE
+		MESSAGE,	// a message from the reliable channel
+		STATS		// the connection quality changed
+	};
+
+	/**
+	 * @brief Something that was received. Only the fields of its type are used.
+	 */
+	struct Event
+	{
+		EventType type = EventType::PACKET;
+		// when it arrived
+		std::chrono::steady_clock::time_point time;
+		protocol::Packet packet;
+		ReliableChannel::Message message;
+		ReliableChannel::Stats stats;
+	};
+
+	// how many events can wait for the render thread, more messages wait in the network thread and more packets are dropped
+	inline static const int QUEUE_CAPACITY = 1024;
+
+	// how many seconds the thread waits for a packet before it sends acks and checks if it should stop
+	inline static const float RECEIVE_TIMEOUT = 0.005f;
+
+	/**
+	 * @brief Creates a new NetworkThread object. It doesn't run before start is called.
+	 */
+	NetworkThread();
+
+	/**
+	 * @brief Stops the thread.
+	 */
+	~NetworkThread();
+
+	/**
+	 * @brief Starts receiving.
+	 * @param tcpSocket The connection to the server.
+	 * @param udpSocket The UDP socket.
+	 * @param serverAddress The server's UDP address.
+	 * @param index The player's index in the server, for the acks.
+	 */
+	void start(sockets::Socket tcpSocket, sockets::Socket udpSocket, sockets::Address serverAddress, int index);
+
+	/**
+	 * @brief Sends a packet to the server right away. Can be called from any thread.
+	 * @param packet The packet.
+	 */
+	void send(const protocol::Packet& packet) const;
+
+	/**
+	 * @brief Takes the next event. Must only be called from one thread.
+	 * @param event Set to the event.
+	 * @return Whether there was an event.
+	 */
+	bool poll(Event& event);
+
+	/**
+	 * @brief Stops the thread, tells the server that the client left and closes the sockets.
+	 */
+	void close();
+
+private:
+	/**
+	 * @brief Receives until the thread stops. Runs on its own thread.
+	 */
+	void run();
+
+	/**
+	 * @brief Passes an event to the render thread, after the events that are waiting for room in the queue.
+	 * @param event The event.
+	 */
+	void pushEvent(Event event);
+
+	/**
+	 * @brief Stops the thread and waits for it.
+	 */
+	void stop();
+
+	sockets::Socket tcpSocket;
+	sockets::Socket udpSocket;
+	sockets::Address serverAddress;
+	int index;
+
+	// used only by the network thread
+	ReliableChannel channel;
+
+	MpscQueue<Event> events;
+	// events that didn't fit in the queue, used only by the network thread
+	std::deque<Event> overflow;
+
+	std::atomic<bool> running;
+	std::thread thread;
+};
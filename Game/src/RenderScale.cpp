@@ -0,0 +1,91 @@
+#include "RenderScale.hpp"
+#include <cmath>
+
+RenderScale::RenderScale() : mode(Mode::DYNAMIC), scale(MAX_SCALE), refreshPeriod(0), shortestFrame(1), missRate(0), framesSinceChange(0), framesSinceMiss(0), raiseFrames(RAISE_FRAMES), raised(false) {}
+
+void RenderScale::setFixed(float scale)
+{
+	mode = Mode::FIXED;
+	this->scale = scale < MIN_SCALE ? MIN_SCALE : scale > MAX_SCALE ? MAX_SCALE : scale;
+}
+
+void RenderScale::setDynamic()
+{
+	mode = Mode::DYNAMIC;
+	missRate = 0;
+	framesSinceChange = 0;
+	framesSinceMiss = 0;
+	raiseFrames = RAISE_FRAMES;
+	raised = false;
+}
+
+void RenderScale::next()
+{
+	if (mode == Mode::DYNAMIC)
+		setFixed(1.0f);
+	else if (scale > 0.75f)
+		setFixed(0.75f);
+	else if (scale > 0.5f)
+		setFixed(0.5f);
+	else
+		setDynamic();
+}
+
+void RenderScale::setRefreshRate(float hertz)
+{
+	if (hertz > 0)
+		refreshPeriod = 1 / hertz;
+}
+
+void RenderScale::update(float frameSeconds)
+{
+	if (frameSeconds >= MIN_REFRESH_PERIOD && frameSeconds < shortestFrame)
+		shortestFrame = frameSeconds;
+
+	if (mode != Mode::DYNAMIC)
+		return;
+
+	// with vsync a frame that is on budget takes one refresh period, and one that isn't waits for the next vsync
+	float period = refreshPeriod > 0 ? refreshPeriod : shortestFrame;
+	bool missed = frameSeconds > period * MISSED_THRESHOLD;
+
+	// smoothed so a single slow frame (loading, a hitch) doesn't change the scale, and measured again after every change
+	missRate = 0.9f * missRate + 0.1f * (missed ? 1.0f : 0.0f);
+	framesSinceChange++;
+	framesSinceMiss = missed ? 0 : framesSinceMiss + 1;
+
+	if (missRate > MISS_RATE && framesSinceChange > COOLDOWN_FRAMES && scale > MIN_SCALE)
+	{
+		// the last raise didn't fit, so the next one waits longer instead of oscillating
+		if (raised && raiseFrames < 8 * RAISE_FRAMES)
+			raiseFrames *= 2;
+
+		scale = scale - STEP < MIN_SCALE ? MIN_SCALE : scale - STEP;
+		framesSinceChange = 0;
+		missRate = 0;
+		raised = false;
+	}
+	else if (framesSinceMiss > raiseFrames && framesSinceChange > raiseFrames && scale < MAX_SCALE)
+	{
+		scale = scale + STEP > MAX_SCALE ? MAX_SCALE : scale + STEP;
+		framesSinceChange = 0;
+		missRate = 0;
+		raised = true;
+	}
+}
+
+float RenderScale::getScale() const
+{
+	return scale;
+}
+
+sf::Vector2u RenderScale::getSize(sf::Vector2u nativeSize) const
+{
+	unsigned int width = (unsigned int)std::lround(nativeSize.x * scale), height = (unsigned int)std::lround(nativeSize.y * scale);
+	return { width > 0 ? width : 1, height > 0 ? height : 1 };
+}
+
+std::string RenderScale::toString() const
+{
+	return std::to_string((int)std::lround(scale * 100)) + "%" + (mode == Mode::DYNAMIC ? " (dynamic)" : "");
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief The resolution the 3D view is rendered at, as a part of the window's size. It's either fixed,
+ * or dynamic: lowered when frames keep missing vsync and raised back after a while without a missed one.
+ * The dynamic scale is measured from the time between two displays, so it counts the GPU's work too, not only the draw calls.
+ */
+class RenderScale
+{
+public:
+	enum class Mode
+	{
+		DYNAMIC,
+		FIXED
+	};
+
+	// the lowest and highest scales
+	inline static const float MIN_SCALE = 0.5f;
+	inline static const float MAX_SCALE = 1.0f;
+
+	// how much the dynamic scale changes at once
+	inline static const float STEP = 0.05f;
+
+	// the shortest refresh period in seconds a measured frame counts as, so a display that returns at once (a minimized window) isn't taken for a fast one
+	inline static const float MIN_REFRESH_PERIOD = 1.0f / 360;
+
+	// a frame longer than this many refresh periods missed a vsync, so it was over budget
+	inline static const float MISSED_THRESHOLD = 1.5f;
+
+	// the scale is lowered when more than this part of the recent frames missed a vsync
+	inline static const float MISS_RATE = 0.2f;
+
+	// how many frames the scale stays after lowering it
+	inline static const int COOLDOWN_FRAMES = 15;
+
+	// how many frames in a row must make every vsync before the scale is raised, doubled (up to 8 times) every time a raise has to be undone
+	inline static const int RAISE_FRAMES = 120;
+
+	/**
+	 * @brief Creates a new RenderScale object, dynamic at the highest scale.
+	 */
+	RenderScale();
+
+	/**
+	 * @brief Fixes the scale.
+	 * @param scale The scale, clamped between MIN_SCALE and MAX_SCALE.
+	 */
+	void setFixed(float scale);
+
+	/**
+	 * @brief Makes the scale dynamic, starting from the current scale.
+	 */
+	void setDynamic();
+
+	/**
+	 * @brief Switches to the next preset: dynamic, then fixed at 100%, 75% and 50%.
+	 */
+	void next();
+
+	/**
+	 * @brief Sets the display's refresh rate, which the window is vsynced to. Until it's set, the refresh period is the shortest frame measured so far.
+	 * @param hertz The refresh rate, ignored unless it's positive.
+	 */
+	void setRefreshRate(float hertz);
+
+	/**
+	 * @brief Adjusts the dynamic scale to how long a frame took. Does nothing if the scale is fixed.
+	 * @param frameSeconds How many seconds passed since the previous frame was displayed, including the wait for vsync.
+	 */
+	void update(float frameSeconds);
+
+	/**
+	 * @brief Returns the scale.
+	 * @return The scale.
+	 */
+	float getScale() const;
+
+	/**
+	 * @brief Returns the resolution to render at.
+	 * @param nativeSize The size of the window.
+	 * @return The size scaled, at least 1x1.
+	 */
+	sf::Vector2u getSize(sf::Vector2u nativeSize) const;
+
+	/**
+	 * @brief Describes the scale, like "75% (dynamic)".
+	 * @return The description.
+	 */
+	std::string toString() const;
+
+private:
+	Mode mode;
+	float scale;
+
+	// the display's refresh period in seconds, 0 if it isn't known
+	float refreshPeriod;
+	// the shortest frame so far, the refresh period when it isn't known
+	float shortestFrame;
+
+	// smoothed part of the frames that missed a vsync
+	float missRate;
+	int framesSinceChange;
+	int framesSinceMiss;
+	// how many frames without a miss raising waits for now
+	int raiseFrames;
+	// whether the last change raised the scale
+	bool raised;
+};
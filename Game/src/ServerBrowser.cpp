@@ -0,0 +1,134 @@
+#include "ServerBrowser.hpp"
+#include <algorithm>
+#include "protocol.hpp"
+#include "globals.hpp"
+#include "logging.hpp"
+
+// every IPv4 host on the local network
+static const char* BROADCAST_IP = "255.255.255.255";
+
+ServerBrowser::ServerBrowser() : running(false), created(clock::now()) {}
+
+ServerBrowser::~ServerBrowser()
+{
+	stop();
+}
+
+void ServerBrowser::start()
+{
+	socket = sockets::Socket(sockets::Protocol::UDP);
+	socket.bind({ "0.0.0.0", 0 });
+	socket.setBlocking(false);
+	socket.setBroadcast(true);
+	running = true;
+
+	// probe on the first update
+	lastProbe = clock::now() - std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(PROBE_INTERVAL));
+}
+
+bool ServerBrowser::update()
+{
+	if (!running)
+		return false;
+
+	clock::time_point now = clock::now();
+	if (now - lastProbe >= std::chrono::duration<float>(PROBE_INTERVAL))
+		probe(now);
+
+	bool changed = receiveAnswers(now);
+
+	// servers that stopped answering
+	const auto timeout = std::chrono::duration<float>(SERVER_TIMEOUT);
+	size_t count = servers.size();
+	servers.erase(std::remove_if(servers.begin(), servers.end(), [&](const Server& server) { return now - server.lastSeen > timeout; }), servers.end());
+	changed |= servers.size() != count;
+
+	return changed;
+}
+
+const std::vector<ServerBrowser::Server>& ServerBrowser::getServers() const
+{
+	return servers;
+}
+
+void ServerBrowser::stop()
+{
+	if (!running)
+		return;
+
+	running = false;
+	socket.close();
+}
+
+void ServerBrowser::probe(clock::time_point now)
+{
+	lastProbe = now;
+
+	protocol::Packet packet;
+	packet.type = protocol::PacketType::DISCOVER;
+	packet.sequence = timestamp(now);
+	// servers don't answer probes smaller than their answer
+	packet.payload.resize(protocol::DISCOVER_SIZE - protocol::encodePacket(packet).size());
+
+	// directly too, so a server keeps answering if broadcasts don't reach it
+	std::vector<sockets::Address> targets = { { BROADCAST_IP, globals::UDP_PORT } };
+	for (const Server& server : servers)
+		targets.push_back(server.address);
+
+	for (const sockets::Address& target : targets)
+	{
+		try
+		{
+			protocol::sendPacket(socket, target, packet);
+		}
+		catch (sockets::exception& err)
+		{
+			logging::warning("Can't send discovery probe", { { "address", target.ip }, { "error", err.what() } });
+		}
+	}
+}
+
+bool ServerBrowser::receiveAnswers(clock::time_point now)
+{
+	bool changed = false;
+
+	protocol::Packet packet;
+	while ((packet = protocol::receivePacket(socket)).type != protocol::PacketType::NO_PACKET)
+	{
+		if (packet.type != protocol::PacketType::SERVER_INFO)
+			continue;
+
+		messages::ServerInfo info;
+		if (!messages::is<messages::ServerInfo>(packet.payload) || !messages::dispatch(packet.payload, [&info](const messages::ServerInfo& received) { info = received; }))
+			continue;
+
+		float rtt = (timestamp(now) - packet.sequence) / 1000.0f;
+		if (rtt < 0)
+			continue;
+
+		auto server = std::find_if(servers.begin(), servers.end(), [&](const Server& known) { return known.address == packet.address; });
+		if (server == servers.end())
+		{
+			servers.push_back({ packet.address, info, rtt, now });
+			logging::info("Found server", { { "address", packet.address.ip }, { "name", info.name } });
+		}
+		else
+		{
+			// smoothed like the reliable channel's round trip time
+			server->rtt = 0.875f * server->rtt + 0.125f * rtt;
+			server->info = info;
+			server->lastSeen = now;
+		}
+		changed = true;
+	}
+
+	if (changed)
+		std::stable_sort(servers.begin(), servers.end(), [](const Server& a, const Server& b) { return a.rtt < b.rtt; });
+
+	return changed;
+}
+
+int ServerBrowser::timestamp(clock::time_point time) const
+{
+	return (int)std::chrono::duration_cast<std::chrono::milliseconds>(time - created).count();
+}
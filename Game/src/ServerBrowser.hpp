@@ -0,0 +1,95 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include "sockets.hpp"
+#include "messages.hpp"
+
+/**
+ * @brief Finds servers on the LAN: broadcasts DISCOVER packets to the UDP port, and keeps the servers that answered
+ * sorted by their round trip time. Servers stay in the list between probes, and are probed directly too,
+ * until they stop answering.
+ */
+class ServerBrowser
+{
+public:
+	/**
+	 * @brief A server that answered.
+	 */
+	struct Server
+	{
+		sockets::Address address;
+		messages::ServerInfo info;
+		// smoothed round trip time in seconds
+		float rtt = 0;
+		std::chrono::steady_clock::time_point lastSeen;
+	};
+
+	// how many seconds between probes
+	inline static const float PROBE_INTERVAL = 1.0f;
+
+	// a server that didn't answer for this many seconds is removed
+	inline static const float SERVER_TIMEOUT = 3.5f;
+
+	/**
+	 * @brief Creates a new ServerBrowser object. It doesn't probe before start is called.
+	 */
+	ServerBrowser();
+
+	/**
+	 * @brief Closes the socket.
+	 */
+	~ServerBrowser();
+
+	/**
+	 * @brief Opens the socket that probes. Throws sockets::exception if it can't.
+	 */
+	void start();
+
+	/**
+	 * @brief Sends probes when they are due and receives the answers, without blocking.
+	 * @return Whether the list changed.
+	 */
+	bool update();
+
+	/**
+	 * @brief Returns the servers that answered, the lowest round trip time first.
+	 * @return The servers.
+	 */
+	const std::vector<Server>& getServers() const;
+
+	/**
+	 * @brief Stops probing and closes the socket.
+	 */
+	void stop();
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Broadcasts a probe, and sends one to every server in the list.
+	 * @param now The current time.
+	 */
+	void probe(clock::time_point now);
+
+	/**
+	 * @brief Receives the answers to the probes.
+	 * @param now The current time.
+	 * @return Whether the list changed.
+	 */
+	bool receiveAnswers(clock::time_point now);
+
+	/**
+	 * @brief Returns the time in milliseconds since the browser was created, for the probes' timestamps.
+	 * @param time The time.
+	 * @return The timestamp.
+	 */
+	int timestamp(clock::time_point time) const;
+
+	sockets::Socket socket;
+	bool running;
+
+	clock::time_point created;
+	clock::time_point lastProbe;
+
+	std::vector<Server> servers;
+};
@@ -1,26 +1,98 @@
 #include "TextureManager.hpp"
 #include "util.hpp"
-#include <iostream>
+#include "logging.hpp"
 
 bool TextureManager::addTexture(std::string id, std::string filename)
 {
-	if (map.find(id) != map.end())
+	sf::Texture* texture = createTexture(id);
+	if (texture == nullptr)
+		return false;
+
+	if (!texture->loadFromFile(filename))
 	{
-		std::cout << "Texture with the ID of '" << id << "' already exists." << std::endl;;
+		map.erase(id);
+		throw std::exception(("ERROR: Can't load " + filename).c_str());
+	}
+
+	return true;
+}
+
+bool TextureManager::addTexture(std::string id, const sf::Image& image, bool repeated)
+{
+	sf::Texture* texture = createTexture(id);
+	if (texture == nullptr)
 		return false;
+
+	if (!texture->loadFromImage(image))
+	{
+		map.erase(id);
+		throw std::exception(("ERROR: Can't create texture '" + id + "'.").c_str());
 	}
 
-	sf::Texture texture;
-	if (!texture.loadFromFile(filename))
-		throw std::exception(("ERROR: Can't load " + filename).c_str());
+	texture->setRepeated(repeated);
+	return true;
+}
+
+bool TextureManager::addTexture(std::string id, const sf::Image& image, const std::vector<sf::Image>& levels, bool repeated)
+{
+	if (!addTexture(id, image, repeated))
+		return false;
+
+	// for the renderer's GPU path, which lets the hardware choose the level
+	map[id].generateMipmap();
+
+	// sf::Texture can't be moved, so the levels are created in place
+	std::vector<sf::Texture>& textures = mipLevels[id];
+	textures.resize(levels.size());
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		if (!textures[i].loadFromImage(levels[i]))
+		{
+			mipLevels.erase(id);
+			throw std::exception(("ERROR: Can't create mip level of texture '" + id + "'.").c_str());
+		}
+		textures[i].setRepeated(repeated);
+	}
 
-	map[id] = texture;
 	return true;
 }
 
+sf::Texture& TextureManager::getLevel(const std::string& id, int level)
+{
+	auto levels = mipLevels.find(id);
+	if (level <= 0 || levels == mipLevels.end() || levels->second.empty())
+		return (*this)[id];
+
+	std::vector<sf::Texture>& textures = levels->second;
+	return textures[level <= (int)textures.size() ? level - 1 : textures.size() - 1];
+}
+
+int TextureManager::getLevelCount(const std::string& id) const
+{
+	auto levels = mipLevels.find(id);
+	return levels == mipLevels.end() ? 1 : (int)levels->second.size() + 1;
+}
+
+bool TextureManager::hasTexture(const std::string& id) const
+{
+	return map.find(id) != map.end();
+}
+
 sf::Texture& TextureManager::operator[](std::string id)
 {
-	if (map.find(id) == map.end())
+	auto texture = map.find(id);
+	if (texture == map.end())
 		throw std::exception(("ERROR: No texture with the ID of '" + id + "'.").c_str());
-	return map[id];
+	return texture->second;
+}
+
+sf::Texture* TextureManager::createTexture(const std::string& id)
+{
+	auto [texture, added] = map.try_emplace(id);
+	if (!added)
+	{
+		logging::warning("Texture already exists", { { "id", id } });
+		return nullptr;
+	}
+	return &texture->second;
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "SFML/Graphics.hpp"
 
 /**
@@ -24,6 +25,59 @@ public:
 	 */
 	bool addTexture(std::string id, std::string filename);
 
+	/**
+	 * @brief Adds a texture to the manager from an image that was already decoded, uploading it to the GPU.
+	 * Must be called from the thread that draws.
+	 * @param id The ID of the new texture.
+	 * @param image The image.
+	 * @param repeated Whether the texture repeats outside its size.
+	 * @return Whether the texture was added or not.
+	 */
+	bool addTexture(std::string id, const sf::Image& image, bool repeated);
+
+	/**
+	 * @brief Adds a texture with a mip chain to the manager. Every level is uploaded as its own texture, for the renderer to choose
+	 * a level by distance, and level 0 also gets mipmaps on the GPU. Must be called from the thread that draws.
+	 * @param id The ID of the new texture.
+	 * @param image The image, level 0.
+	 * @param levels The smaller levels, from buildMipChain.
+	 * @param repeated Whether the texture repeats outside its size.
+	 * @return Whether the texture was added or not.
+	 */
+	bool addTexture(std::string id, const sf::Image& image, const std::vector<sf::Image>& levels, bool repeated);
+
+	/**
+	 * @brief Gets a mip level of a texture.
+	 * @param id The ID of the texture.
+	 * @param level The level, 0 is the texture itself. Levels the texture doesn't have return its smallest level.
+	 * @return The level. If no texture exists with this ID, throws an exception.
+	 */
+	sf::Texture& getLevel(const std::string& id, int level);
+
+	/**
+	 * @brief Returns how many mip levels a texture has.
+	 * @param id The ID of the texture.
+	 * @return The number of levels, including level 0 (1 if it has no mip chain).
+	 */
+	int getLevelCount(const std::string& id) const;
+
+	/**
+	 * @brief Checks if a texture exists.
+	 * @param id The ID of the texture.
+	 * @return Whether a texture exists with this ID.
+	 */
+	bool hasTexture(const std::string& id) const;
+
 private:
+	/**
+	 * @brief Creates an empty texture in the map, where it is loaded, so it's never copied.
+	 * @param id The ID of the new texture.
+	 * @return The new texture, or nullptr if a texture already exists with this ID.
+	 */
+	sf::Texture* createTexture(const std::string& id);
+
 	std::unordered_map<std::string, sf::Texture> map;
+
+	// the levels after level 0 of the textures that have a mip chain
+	std::unordered_map<std::string, std::vector<sf::Texture>> mipLevels;
 };
@@ -1,55 +1,106 @@
 #include "sockets.hpp"
-#include "states/MainMenuState.hpp"
+#include <Windows.h>
+#include "states/LoadingState.hpp"
 #include "states/StateManager.hpp"
 #include "Members.hpp"
+#include "logging.hpp"
 
 const int WINDOW_WIDTH = 800;
 const int WINDOW_HEIGHT = 600;
 
+// the packed assets, loaded instead of the files in assets/ if it exists
+const std::string ASSET_ARCHIVE = "assets.pak";
+
+const std::string FONT_FILE = "assets/retro.ttf";
+
+/**
+ * @brief A texture that the game loads.
+ */
+struct TextureAsset
+{
+	std::string id;
+	std::string filename;
+	bool repeated;
+	// the 3D view chooses a mip level by distance
+	bool mipmapped;
+};
+
+const std::vector<TextureAsset> TEXTURES = {
+	{ "floor", "assets/wood.png", true, true },
+	{ "ceiling", "assets/colorstone.png", true, true },
+	{ "wall", "assets/redbrick.png", false, true },
+	{ "character", "assets/character.png", false, false },
+	{ "playButton", "assets/playButton.png", false, false },
+	{ "playButtonPressed", "assets/playButtonPressed.png", false, false },
+	{ "bullet", "assets/bullet.png", false, false },
+	{ "heart", "assets/heart.png", false, false },
+	{ "logo", "assets/logo.png", false, false },
+	{ "crosshair", "assets/crosshair.png", false, false }
+};
+
+/**
+ * @brief Starts loading all the textures and the font in the background. LoadingState waits for them.
+ * @param assets The asset loader.
+ */
+static void loadAssets(AssetLoader& assets)
+{
+	assets.openArchive(ASSET_ARCHIVE);
+
+	for (const TextureAsset& texture : TEXTURES)
+		assets.loadTexture(texture.id, texture.filename, texture.repeated, texture.mipmapped);
+	assets.loadFont(FONT_FILE);
+}
+
 /**
- * @brief Loads all the textures.
- * @param textures The texture manager.
+ * @brief Packs all the assets into the archive.
+ * @return Whether the archive was written.
  */
-static void loadTextures(TextureManager& textures)
+static bool packAssets()
 {
-	textures.addTexture("floor", "assets/wood.png");
-	textures["floor"].setRepeated(true);
-	textures.addTexture("ceiling", "assets/colorstone.png");
-	textures["ceiling"].setRepeated(true);
-	textures.addTexture("wall", "assets/redbrick.png");
-	textures.addTexture("character", "assets/character.png");
-	textures.addTexture("playButton", "assets/playButton.png");
-	textures.addTexture("playButtonPressed", "assets/playButtonPressed.png");
-	textures.addTexture("bullet", "assets/bullet.png");
-	textures.addTexture("heart", "assets/heart.png");
-	textures.addTexture("logo", "assets/logo.png");
-	textures.addTexture("crosshair", "assets/crosshair.png");
+	std::vector<std::string> files;
+	for (const TextureAsset& texture : TEXTURES)
+		files.push_back(texture.filename);
+	files.push_back(FONT_FILE);
+
+	return AssetArchive::pack(files, ASSET_ARCHIVE);
 }
 
 /**
  * @brief The main function.
+ * @param argc The number of arguments.
+ * @param argv The arguments, "--spectate" watches a game instead of playing, "--pack-assets" packs the assets into the archive and exits.
  * @return Exit code.
  */
-int main()
+int main(int argc, char* argv[])
 {
 	sockets::initialize();
+	logging::start();
+
+	if (argc == 2 && std::string(argv[1]) == "--pack-assets")
+	{
+		bool packed = packAssets();
+		logging::stop();
+		sockets::shutdown();
+		return packed ? 0 : 1;
+	}
 
 	Members members;
+	members.spectating = argc == 2 && std::string(argv[1]) == "--spectate";
 
 	// creating window
 	members.window.create(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Chaos Corridors", sf::Style::Titlebar | sf::Style::Close);
 	members.window.setVerticalSyncEnabled(true);
 
-	// loading textures
-	loadTextures(members.textures);
-
-	// loading font
-	if (!members.font.loadFromFile("assets/retro.ttf"))
-		throw std::exception("Couldn't load font.");
+	// the desktop's refresh rate, which vsync waits for (0 or 1 means the hardware's default, so the render scale measures it instead)
+	DEVMODEA displayMode = {};
+	displayMode.dmSize = sizeof(displayMode);
+	if (EnumDisplaySettingsA(NULL, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1)
+		members.renderScale.setRefreshRate((float)displayMode.dmDisplayFrequency);
 
-	// loading main menu
-	std::unique_ptr<MainMenuState> mainMenuState = std::make_unique<MainMenuState>(members);
-	members.manager.addState(std::move(mainMenuState));
+	// loading textures and font, the loading state shows the main menu when they are done
+	loadAssets(members.assets);
+	std::unique_ptr<LoadingState> loadingState = std::make_unique<LoadingState>(members);
+	members.manager.addState(std::move(loadingState));
 
 	// game loop
 	while (members.manager.isRunning())
@@ -59,5 +110,6 @@ int main()
 		members.manager.draw();
 	}
 
+	logging::stop();
 	sockets::shutdown();
 }
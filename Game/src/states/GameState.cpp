@@ -3,8 +3,10 @@
 #include "util.hpp"
 #include "globals.hpp"
 #include "protocol.hpp"
+#include "messages.hpp"
 #include "EndState.hpp"
-#include <iostream>
+#include "logging.hpp"
+#include "../Mipmaps.hpp"
 
 struct Sprite
 {
@@ -12,39 +14,46 @@ struct Sprite
 	sf::Vector2f position;
 };
 
-GameState::GameState(Members& members, bool isFocused, std::string ip)
-	: members(members), maze(), isFocused(isFocused), player({ 0, 0 }), zBuffer(members.window.getSize().x + 1)
+GameState::GameState(Members& members, bool isFocused, std::string ip, const globals::MazeArr& maze)
+	: members(members), maze(maze), isFocused(isFocused), player({ 0, 0 }), hud(members.textures, members.font, members.window.getSize()), minimap(this->maze), zBuffer(members.window.getSize().x + 1)
 {
-	members.udpSocket.setBlocking(false);
-
-	members.tcpSocket.setBlocking(true);
-	maze = members.tcpSocket.recv<globals::MazeArr>();
-	members.tcpSocket.setBlocking(false);
-
-	serverAddressUDP = { ip, globals::UDP_PORT };
-
-	heartSprite.setTexture(members.textures["heart"]);
+	serverAddressUDP = { ip, members.spectating ? globals::SPECTATOR_PORT : globals::UDP_PORT };
+	network.start(members.tcpSocket, members.udpSocket, serverAddressUDP, members.playerIndex);
 
 	timer = 0;
 	score = 0;
 
-	timerText.setFont(members.font);
-	timerText.setPosition(0, heartSprite.getGlobalBounds().height);
-	timerText.setCharacterSize(heartSprite.getGlobalBounds().height);
-
-	scoreText.setFont(members.font);
-	scoreText.setCharacterSize(heartSprite.getGlobalBounds().height);
-	scoreText.setPosition(0, 2 * heartSprite.getGlobalBounds().height);
+	// spectators have no lives or score
+	hud.setPlayerShown(!members.spectating);
 
 	centerScreenPos = { (int)members.window.getSize().x / 2, (int)members.window.getSize().y / 2 };
 	paused = false;
 
 	dt = 0;
 	elapsedTime = 0;
-
-	crosshair.setTexture(members.textures["crosshair"]);
-	crosshair.setOrigin(crosshair.getLocalBounds().getSize() / 2);
-	crosshair.setPosition((float)centerScreenPos.x, (float)centerScreenPos.y);
+	inputSequence = 0;
+	lastAckedInput = 0;
+
+	serverTick = 0;
+	renderTick = 0;
+	hasServerTick = false;
+	interpolationDelay = MIN_INTERPOLATION_DELAY;
+	lastBulletTick = 0;
+
+	netGraphText.setFont(members.font);
+	netGraphText.setCharacterSize(20);
+	showNetGraph = false;
+	gpuMipmaps = false;
+
+	// the cells every cell can see, for culling the walls' rays, the players and the bullets
+	visibility.compute(this->maze);
+
+	// big enough for the highest scale, lower scales use part of it
+	if (!scene.create(members.window.getSize().x, members.window.getSize().y))
+		throw std::exception("ERROR: Can't create the render texture of the 3D view.");
+	scene.setSmooth(true);
+	sceneSprite.setTexture(scene.getTexture());
+	renderSize = members.window.getSize();
 }
 
 void GameState::resetMousePos()
@@ -78,125 +87,280 @@ void GameState::shootBullet()
 	packet.index = members.playerIndex;
 	packet.position = bulletPosition;
 	packet.direction = player.direction;
+	// the tick the other players are rendered at, for lag compensation
+	packet.tick = (int)renderTick;
 
-	protocol::sendPacket(members.udpSocket, serverAddressUDP, packet);
+	network.send(packet);
 }
 
-void GameState::receiveUDP()
+bool GameState::handleEvents()
 {
-	try
+	NetworkThread::Event event;
+	while (network.poll(event))
 	{
-		protocol::PacketType receivedType = protocol::PacketType::NO_PACKET;
-		// receive until received NO_PACKET
-		do
-		{
-			protocol::Packet packet = protocol::receivePacket(members.udpSocket);
-			receivedType = packet.type;
+		if (event.type == NetworkThread::EventType::PACKET)
+			handlePacket(event.packet, event.time);
 
-			if (packet.type == protocol::PacketType::UPDATE_BULLET)
-				bullets[packet.index] = packet.position;
+		else if (event.type == NetworkThread::EventType::STATS)
+			networkStats = event.stats;
+
+		else if (event.type == NetworkThread::EventType::MESSAGE && !handleMessage(event.message))
+			return false;
+	}
 
-			else if (packet.type == protocol::PacketType::CLEAR_BULLETS)
-				bullets.clear();
+	return true;
+}
 
-			else if (packet.type == protocol::PacketType::UPDATE_PLAYER && packet.index != members.playerIndex)
-				targetPlayerPositions[packet.index] = packet.position;
+void GameState::handlePacket(const protocol::Packet& packet, std::chrono::steady_clock::time_point time)
+{
+	std::chrono::duration<float> age = std::chrono::steady_clock::now() - time;
+	updateServerTick(packet.tick, age.count());
 
-		}
-		while (receivedType != protocol::PacketType::NO_PACKET);
-	}
-	catch (sockets::exception& err)
+	if (packet.type == protocol::PacketType::UPDATE_BULLET)
 	{
-		std::cout << "UDP error: " << err.what() << std::endl;
+		Handle handle = Handle::fromID(packet.index);
+		if (!bullets.contains(handle))
+			bullets.insertAt(handle, packet.position, InterpolationBuffer(), false);
+		if (InterpolationBuffer* snapshots = bullets.get<SNAPSHOTS>(handle))
+			snapshots->push(packet.tick, packet.position);
 	}
-}
 
-bool GameState::receiveTCP()
-{
-	try
+	else if (packet.type == protocol::PacketType::CLEAR_BULLETS)
+		lastBulletTick = std::max(lastBulletTick, packet.tick);
+
+	else if (packet.type == protocol::PacketType::UPDATE_PLAYER)
 	{
-		std::string receivedKey = "";
-		// receive until received empty message
-		do
+		if (packet.index == members.playerIndex && !members.spectating)
+			reconcile(packet.position, packet.sequence);
+		else
 		{
-			auto [key, value] = protocol::receiveKeyValue(members.tcpSocket);
-			receivedKey = key;
-
-			if (key == "hit") // no value
-				player.lives--;
+			Handle handle = Handle::fromID(packet.index);
+			if (!players.contains(handle))
+				players.insertAt(handle, packet.position, InterpolationBuffer());
+			if (InterpolationBuffer* snapshots = players.get<SNAPSHOTS>(handle))
+				snapshots->push(packet.tick, packet.position);
+		}
+	}
+}
 
-			else if (key == "timer") // value is new timer
-				timer = std::stoi(value);
+bool GameState::handleMessage(const ReliableChannel::Message& message)
+{
+	bool running = true;
 
-			else if (key == "score") // value is score modifier
-				score += std::stoi(value);
+	messages::dispatch(message, messages::Handlers{
+		[&](const messages::Hit&)
+		{
+			player.lives--;
+		},
+		[&](const messages::Timer& timerUpdate)
+		{
+			timer = timerUpdate.seconds;
+		},
+		[&](const messages::Score& scored)
+		{
+			score += scored.points;
+		},
+		[&](const messages::Exit& left)
+		{
+			players.remove(Handle::fromID(left.index));
+		},
+		[&](const messages::End& end)
+		{
+			members.window.setMouseCursorVisible(true);
 
-			else if (key == "exit") // value is the index of who left
-			{
-				char index = std::stoi(value);
-				players.erase(index);
-				targetPlayerPositions.erase(index);
-			}
+			std::unique_ptr<EndState> endState = std::make_unique<EndState>(members, end.winners);
+			members.manager.setState(std::move(endState));
 
-			else if (key == "end") // value is who won
+			network.close();
+			running = false;
+		},
+		[&](const messages::Init& init)
+		{
+			if (init.index == members.playerIndex && !members.spectating)
 			{
-				members.window.setMouseCursorVisible(true);
-
-				std::unique_ptr<EndState> endState = std::make_unique<EndState>(members, value);
-				members.manager.setState(std::move(endState));
-
-				members.tcpSocket.send(protocol::keyValueMessage("close", ""));
-				members.tcpSocket.close();
-				members.udpSocket.close();
-				return false;
+				player.pos = init.position;
+				player.lives = globals::MAX_LIFE;
+				pendingInputs.clear();
 			}
-
-			else if (key == "init") // value is index, x, y
+			else
 			{
-				std::vector<std::string> split = splitString(value, ' ');
-				int index = std::stoi(split[0]);
-				float x = std::stof(split[1]);
-				float y = std::stof(split[2]);
-				if (index == members.playerIndex)
+				// don't interpolate from where the player died
+				Handle handle = Handle::fromID(init.index);
+				if (players.contains(handle))
 				{
-					player.pos = { x, y };
-					player.lives = globals::MAX_LIFE;
+					*players.get<POSITION>(handle) = init.position;
+					players.get<SNAPSHOTS>(handle)->clear();
 				}
 				else
-					players[index] = { x, y };
+					players.insertAt(handle, init.position, InterpolationBuffer());
 			}
-
 		}
-		while (receivedKey != "");
+	});
+
+	return running;
+}
+
+void GameState::updateServerTick(int tick, float age)
+{
+	// the tick is newer by the time the event waited for the frame
+	float receivedTick = tick + age * globals::SERVER_TICKS;
+
+	if (!hasServerTick || fabsf(receivedTick - serverTick) > MAX_TICK_DRIFT)
+	{
+		serverTick = receivedTick;
+		hasServerTick = true;
 	}
-	catch (sockets::exception& err)
+	// nudge slowly so the render time stays smooth
+	else
+		serverTick += (receivedTick - serverTick) * 0.05f;
+}
+
+void GameState::interpolateEntities()
+{
+	if (hasServerTick)
+		serverTick += dt * globals::SERVER_TICKS;
+
+	renderTick = serverTick - interpolationDelay * globals::SERVER_TICKS;
+
+	for (int i = 0; i < players.size(); i++)
 	{
-		std::cout << "TCP error: " << err.what() << std::endl;
+		const InterpolationBuffer& snapshots = players.column<SNAPSHOTS>()[i];
+		if (!snapshots.empty())
+			players.column<POSITION>()[i] = snapshots.sample(renderTick);
 	}
 
-	return true;
+	// backwards, because removing moves the last bullet to the removed one's place
+	for (int i = bullets.size() - 1; i >= 0; i--)
+	{
+		const InterpolationBuffer& snapshots = bullets.column<SNAPSHOTS>()[i];
+
+		// the server stopped sending the bullet and we already rendered its last position
+		if (snapshots.newestTick() < lastBulletTick && snapshots.newestTick() <= renderTick)
+		{
+			bullets.remove(bullets.handleAt(i));
+			continue;
+		}
+
+		// don't show bullets before the render time reaches them
+		bool visible = snapshots.oldestTick() <= renderTick;
+		bullets.column<VISIBLE>()[i] = visible;
+		if (visible)
+			bullets.column<POSITION>()[i] = snapshots.sample(renderTick);
+	}
 }
 
-void GameState::movePlayers()
+void GameState::followPlayer()
 {
-	for (auto& [index, targetPosition] : targetPlayerPositions)
+	if (players.size() == 0)
+		return;
+
+	if (!players.contains(followed))
+		followed = players.handleAt(0);
+
+	player.pos = *players.get<POSITION>(followed);
+}
+
+void GameState::followNextPlayer()
+{
+	for (int i = 0; i < players.size(); i++)
 	{
-		sf::Vector2f actualPosition = players[index];
-		sf::Vector2f direction = targetPosition - actualPosition;
-		if (vecMagnitude(direction) <= 0.01f)
-			continue;
-		players[index] += vecNormalize(direction) * dt * Player::SPEED;
+		if (players.handleAt(i) == followed)
+		{
+			followed = players.handleAt((i + 1) % players.size());
+			return;
+		}
 	}
 }
 
-void GameState::sendPosition()
+void GameState::tuneInterpolationDelay()
+{
+	const ReliableChannel::Stats& stats = networkStats;
+	if (!stats.measured)
+		return;
+
+	// the server rewinds hits by the delay and the round trip, up to MAX_REWIND_TICKS
+	float rewindSeconds = globals::MAX_REWIND_TICKS / (float)globals::SERVER_TICKS;
+	float maxDelay = std::clamp(rewindSeconds - stats.rtt, MIN_INTERPOLATION_DELAY, MAX_INTERPOLATION_DELAY);
+
+	// two deviations cover most of the late packets
+	float target = std::clamp(MIN_INTERPOLATION_DELAY + 2 * stats.jitter, MIN_INTERPOLATION_DELAY, maxDelay);
+
+	// change slowly, so the other players don't jump
+	interpolationDelay += (target - interpolationDelay) * std::min(dt, 1.0f);
+}
+
+void GameState::drawNetGraph()
+{
+	const ReliableChannel::Stats& stats = networkStats;
+
+	std::string text =
+		"RTT: " + std::to_string((int)(stats.rtt * 1000)) + "ms\n" +
+		"Jitter: " + std::to_string((int)(stats.jitter * 1000)) + "ms\n" +
+		"Loss: " + std::to_string((int)(stats.loss * 100)) + "%\n" +
+		"Delay: " + std::to_string((int)(interpolationDelay * 1000)) + "ms\n" +
+		"Render: " + members.renderScale.toString();
+	netGraphText.setString(text);
+
+	// top right corner
+	netGraphText.setPosition(members.window.getSize().x - netGraphText.getGlobalBounds().width - 10, 0);
+	members.window.draw(netGraphText);
+}
+
+PlayerInput GameState::sendInput(const PlayerInput& input)
 {
 	protocol::Packet packet;
-	packet.type = protocol::PacketType::UPDATE_PLAYER;
+	packet.type = protocol::PacketType::PLAYER_INPUT;
 	packet.index = members.playerIndex;
-	packet.position = player.pos;
+	packet.direction = input.direction;
+	packet.sequence = input.sequence;
+	packet.input = input.wasd;
 
-	protocol::sendPacket(members.udpSocket, serverAddressUDP, packet);
+	network.send(packet);
+
+	// the server simulates the decoded input, predicting with the exact one would need a correction on every update
+	protocol::Packet sent = protocol::quantize(packet);
+	return { input.sequence, sent.input, sent.direction };
+}
+
+void GameState::processInput()
+{
+	sf::Vector2f wasd;
+
+	if (isFocused && !paused)
+		wasd = wasdInput();
+
+	// don't try to catch up after a long freeze
+	elapsedTime = std::min(elapsedTime, MAX_INPUT_STEPS * Player::INPUT_STEP);
+
+	while (elapsedTime >= Player::INPUT_STEP)
+	{
+		elapsedTime -= Player::INPUT_STEP;
+
+		PlayerInput input = sendInput({ ++inputSequence, wasd, player.direction });
+
+		player.applyInput(input, maze);
+		pendingInputs.push_back(input);
+	}
+}
+
+void GameState::reconcile(sf::Vector2f position, int lastInput)
+{
+	// ignore updates that arrived out of order
+	if (lastInput < lastAckedInput)
+		return;
+	lastAckedInput = lastInput;
+
+	while (!pendingInputs.empty() && pendingInputs.front().sequence <= lastInput)
+		pendingInputs.pop_front();
+
+	float direction = player.direction;
+
+	player.pos = position;
+	for (auto& input : pendingInputs)
+		player.applyInput(input, maze);
+
+	// the replayed inputs shouldn't change where the player looks
+	player.direction = direction;
 }
 
 void GameState::update()
@@ -211,18 +375,24 @@ void GameState::update()
 		if (event.type == sf::Event::Closed)
 		{
 			members.manager.quit();
-			members.tcpSocket.send(protocol::keyValueMessage("close", ""));
-			protocol::receiveKeyValue(members.tcpSocket); // to stop closing with RST
-			members.tcpSocket.close();
-
-			members.udpSocket.close();
+			network.close();
 			return;
 		}
 
 		else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
 			paused = !paused;
 
-		else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && !paused)
+		else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+			showNetGraph = !showNetGraph;
+		else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4)
+			gpuMipmaps = !gpuMipmaps;
+		else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5)
+			members.renderScale.next();
+
+		else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Tab && members.spectating)
+			followNextPlayer();
+
+		else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && !paused && !members.spectating)
 			shootBullet();
 
 		else if (event.type == sf::Event::LostFocus)
@@ -232,27 +402,20 @@ void GameState::update()
 			isFocused = true;
 	}
 
-	if (!receiveTCP())
+	if (!handleEvents())
 		return;
-	receiveUDP();
 
-	movePlayers();
+	tuneInterpolationDelay();
+	interpolateEntities();
 
-	// send position NUMBER_OF_TICKS times per second.
-	if (elapsedTime >= 1.0f / NUMBER_OF_TICKS)
-	{
-		sendPosition();
-		elapsedTime = 0;
-	}
+	if (members.spectating)
+		followPlayer();
 
 	if (paused)
-	{
 		members.window.setMouseCursorVisible(true);
-		return;
-	}
 
 	// setting player's direction according to mouse
-	if (isFocused)
+	else if (isFocused)
 	{
 		members.window.setMouseCursorVisible(false);
 		setPlayerDirection();
@@ -261,34 +424,45 @@ void GameState::update()
 	else
 		members.window.setMouseCursorVisible(true);
 
-	// getting input
-	sf::Vector2f wasd;
-
-	if (isFocused)
-		wasd = wasdInput();
-
-	player.calculateVelocity(wasd, dt);
-	player.checkCollision(maze);
-	player.move();
+	// simulate and send input INPUT_TICKS times per second, spectators only look around
+	if (!members.spectating)
+		processInput();
 }
 
 void GameState::draw()
 {
-	members.window.clear(sf::Color::Black);
+	// the 3D view is rendered at the render scale into the top left of the scene, and stretched over the window
+	renderSize = members.renderScale.getSize(members.window.getSize());
+	scene.clear(sf::Color::Black);
 
 	drawFloorAndCeiling();
 	drawWalls();
 
 	std::vector<Sprite> sprites;
 
-	for (auto& [index, position] : players)
+	// players and bullets in cells that can't be seen from the player's cell aren't drawn
+	visibility.getVisible({ (int)player.pos.x, (int)player.pos.y }, visibleCells);
+	auto canBeSeen = [this](sf::Vector2f position)
 	{
-		sprites.push_back({ "character", position });
+		sf::Vector2i cell = { (int)position.x, (int)position.y };
+		if (cell.x < 0 || cell.x >= globals::WORLD_WIDTH || cell.y < 0 || cell.y >= globals::WORLD_HEIGHT)
+			return true;
+		return (bool)visibleCells[cell.y * globals::WORLD_WIDTH + cell.x];
+	};
+
+	for (int i = 0; i < players.size(); i++)
+	{
+		// the camera is inside the followed player
+		if (members.spectating && players.handleAt(i) == followed)
+			continue;
+		if (canBeSeen(players.column<POSITION>()[i]))
+			sprites.push_back({ "character", players.column<POSITION>()[i] });
 	}
 
-	for (auto& [index, position] : bullets)
+	for (int i = 0; i < bullets.size(); i++)
 	{
-		sprites.push_back({ "bullet", position });
+		if (bullets.column<VISIBLE>()[i] && canBeSeen(bullets.column<POSITION>()[i]))
+			sprites.push_back({ "bullet", bullets.column<POSITION>()[i] });
 	}
 
 	std::sort(sprites.begin(), sprites.end(),
@@ -303,31 +477,30 @@ void GameState::draw()
 		drawSprite(sprite.position, sprite.texture);
 	}
 
-	for (int i = 0; i < player.lives; i++)
-	{
-		heartSprite.setPosition({ i * heartSprite.getGlobalBounds().width, 0 });
-		members.window.draw(heartSprite);
-	}
+	scene.display();
 
-	std::string secondsString = std::to_string(timer % 60);
-	std::string leadingZeros = std::string(2 - std::min(2, (int)secondsString.length()), '0');
-	// pad seconds with zeros
-	std::string timerString = std::to_string(timer / 60) + ":" + leadingZeros + secondsString;
-	timerText.setString(timerString);
-
-	sf::Color timerColor;
-	timerColor.g = (int)((255.0f / globals::GAME_TIME) * timer);
-	timerColor.r = 255 - timerColor.g;
-	timerText.setFillColor(timerColor);
+	members.window.clear(sf::Color::Black);
+	sceneSprite.setTextureRect({ 0, 0, (int)renderSize.x, (int)renderSize.y });
+	sceneSprite.setScale((float)members.window.getSize().x / renderSize.x, (float)members.window.getSize().y / renderSize.y);
+	members.window.draw(sceneSprite);
 
-	members.window.draw(timerText);
+	// the HUD is drawn at the window's resolution, and only laid out again when something in it changed
+	hud.setTimer(timer);
+	hud.setScore(score);
+	hud.setLives(player.lives);
+	hud.draw(members.window);
 
-	scoreText.setString(std::to_string(score));
-	members.window.draw(scoreText);
+	// only the cells the walls' rays revealed this frame are drawn into the map
+	minimap.update();
+	minimap.draw(members.window, player.pos, player.direction);
 
-	members.window.draw(crosshair);
+	if (showNetGraph)
+		drawNetGraph();
 
 	members.window.display();
+
+	// from display to display, so the GPU's work and missed vsyncs are counted, not only the draw calls
+	members.renderScale.update(frameClock.restart().asSeconds());
 }
 
 Ray GameState::raycast(float angle)
@@ -371,9 +544,13 @@ Ray GameState::raycast(float angle)
 		rayLength1D.y = (float(currentCell.y + 1) - player.pos.y) * rayUnitStepSize.y;
 	}
 
+	// the cells the ray passes are seen, and so is the wall it hits
+	minimap.reveal(currentCell);
+
 	bool foundCell = false;
 	bool verticalHit = false;
-	float maxDistance = globals::WORLD_WIDTH;
+	// no wall that can be seen from this cell is further
+	float maxDistance = visibility.getRadius(currentCell);
 	float distance = 0;
 	float hitCoord = 0;
 
@@ -397,6 +574,7 @@ Ray GameState::raycast(float angle)
 
 		if (currentCell.x >= 0 && currentCell.x < globals::WORLD_WIDTH && currentCell.y >= 0 && currentCell.y < globals::WORLD_HEIGHT)
 		{
+			minimap.reveal(currentCell);
 			if (maze[currentCell.y][currentCell.x] == globals::CELL_WALL)
 			{
 				foundCell = true;
@@ -422,14 +600,19 @@ void GameState::drawFloorAndCeiling()
 	// for doing floor/ceiling things
 	float cos = cosf(player.direction), sin = sinf(player.direction);
 
-	sf::VertexArray floorLines(sf::Lines, members.window.getSize().y + 2);
-	sf::VertexArray ceilingLines(sf::Lines, members.window.getSize().y + 2);
+	// a batch of rows for every mip level
+	int floorLevels = members.textures.getLevelCount("floor");
+	int ceilingLevels = members.textures.getLevelCount("ceiling");
+	std::vector<sf::VertexArray> floorLines(floorLevels, sf::VertexArray(sf::Lines));
+	std::vector<sf::VertexArray> ceilingLines(ceilingLevels, sf::VertexArray(sf::Lines));
 
-	for (int y = 0; y <= members.window.getSize().y / 2; y++)
+	// floor and ceiling texture have the same size so it doesn't matter which size is in the formulas
+	float textureSize = (float)members.textures["floor"].getSize().x;
+
+	for (int y = 0; y <= renderSize.y / 2; y++)
 	{
 		// the distance of the current row
-		// floor and ceiling texture have the same size so it doesn't matter which size is in the formula
-		int d = members.textures["floor"].getSize().x * members.window.getSize().y / 2 / (y + 1);
+		int d = members.textures["floor"].getSize().x * renderSize.y / 2 / (y + 1);
 
 		sf::Vector2f startPos = {
 			d * cos - d * tan * sin,
@@ -442,6 +625,7 @@ void GameState::drawFloorAndCeiling()
 
 		// calculating shading based on distance
 		sf::Color color = sf::Color::White;
+		// the window's height, so the floor is shaded the same at every render scale
 		float brightness = 1.0f - (float)d / members.window.getSize().y;
 		if (brightness < 0)
 			brightness = 0;
@@ -449,34 +633,35 @@ void GameState::drawFloorAndCeiling()
 		color.g *= brightness;
 		color.b *= brightness;
 
+		// the row is 2 * d * tan texels long, choosing the level where a texel is about a pixel
+		float texelsPerPixel = 2 * d * tan / renderSize.x;
+		int floorLevel = gpuMipmaps ? 0 : chooseMipLevel(texelsPerPixel, floorLevels);
+		int ceilingLevel = gpuMipmaps ? 0 : chooseMipLevel(texelsPerPixel, ceilingLevels);
+
 		// floor
 
-		// texturing the floor according to the start and end sample positions and the player position
-		floorLines[2 * y].texCoords = endPos + player.pos * members.textures["floor"].getSize().x;
-		floorLines[2 * y + 1].texCoords = startPos + player.pos * members.textures["floor"].getSize().x;
-		// shading
-		floorLines[2 * y].color = color;
-		floorLines[2 * y + 1].color = color;
-		// setting floor position
-		floorLines[2 * y].position = { 0, (float)y + members.window.getSize().y / 2 };
-		floorLines[2 * y + 1].position = { (float)members.window.getSize().x, (float)y + members.window.getSize().y / 2 };
+		// texturing the floor according to the start and end sample positions and the player position, in the texels of the level
+		float floorScale = members.textures.getLevel("floor", floorLevel).getSize().x / textureSize;
+		float floorY = (float)y + renderSize.y / 2;
+		floorLines[floorLevel].append(sf::Vertex({ 0, floorY }, color, (endPos + player.pos * textureSize) * floorScale));
+		floorLines[floorLevel].append(sf::Vertex({ (float)renderSize.x, floorY }, color, (startPos + player.pos * textureSize) * floorScale));
 
 
 		// ceiling
 
-		// texturing the ceiling according to the start and end sample positions and the player position
-		ceilingLines[2 * y].texCoords = endPos + player.pos * members.textures["ceiling"].getSize().x;
-		ceilingLines[2 * y + 1].texCoords = startPos + player.pos * members.textures["ceiling"].getSize().x;
-		// shading
-		ceilingLines[2 * y].color = color;
-		ceilingLines[2 * y + 1].color = color;
-		// setting ceiling position
-		ceilingLines[2 * y].position = { 0, members.window.getSize().y / 2 - (float)y };
-		ceilingLines[2 * y + 1].position = { (float)members.window.getSize().x, members.window.getSize().y / 2 - (float)y };
+		// texturing the ceiling according to the start and end sample positions and the player position, in the texels of the level
+		float ceilingScale = members.textures.getLevel("ceiling", ceilingLevel).getSize().x / textureSize;
+		float ceilingY = renderSize.y / 2 - (float)y;
+		ceilingLines[ceilingLevel].append(sf::Vertex({ 0, ceilingY }, color, (endPos + player.pos * textureSize) * ceilingScale));
+		ceilingLines[ceilingLevel].append(sf::Vertex({ (float)renderSize.x, ceilingY }, color, (startPos + player.pos * textureSize) * ceilingScale));
 	}
 
-	members.window.draw(floorLines, &members.textures["floor"]);
-	members.window.draw(ceilingLines, &members.textures["ceiling"]);
+	for (int level = 0; level < floorLevels; level++)
+		if (floorLines[level].getVertexCount() > 0)
+			scene.draw(floorLines[level], &members.textures.getLevel("floor", level));
+	for (int level = 0; level < ceilingLevels; level++)
+		if (ceilingLines[level].getVertexCount() > 0)
+			scene.draw(ceilingLines[level], &members.textures.getLevel("ceiling", level));
 }
 
 void GameState::drawWalls()
@@ -485,12 +670,15 @@ void GameState::drawWalls()
 	// math taken from here:
 	// https://stackoverflow.com/questions/24173966/raycasting-engine-rendering-creating-slight-distortion-increasing-towards-edges
 	float screenHalfLen = tanf(Player::FOV / 2);
-	float segLen = 2 * screenHalfLen / members.window.getSize().x;
+	float segLen = 2 * screenHalfLen / renderSize.x;
 
-	sf::VertexArray wallLines(sf::Lines, 2 * (members.window.getSize().x + 1));
+	// a batch of columns for every mip level
+	int levels = members.textures.getLevelCount("wall");
+	std::vector<sf::VertexArray> wallLines(levels, sf::VertexArray(sf::Lines));
+	sf::Vector2f textureSize = (sf::Vector2f)members.textures["wall"].getSize();
 
 	float angle;
-	for (int x = 0; x <= members.window.getSize().x; x++)
+	for (int x = 0; x <= renderSize.x; x++)
 	{
 		// angle calculation such that the walls aren't distorted
 		angle = player.direction + atanf(segLen * x - screenHalfLen);
@@ -504,11 +692,11 @@ void GameState::drawWalls()
 		if (!ray.isHit)
 			continue;
 
-		float wallHeight = (float)members.window.getSize().y / ray.distance;
+		float wallHeight = (float)renderSize.y / ray.distance;
 
 		// calculating floor and ceiling y values
-		float ceiling = (members.window.getSize().y - wallHeight) / 2.0f;
-		float floor = members.window.getSize().y - ceiling;
+		float ceiling = (renderSize.y - wallHeight) / 2.0f;
+		float floor = renderSize.y - ceiling;
 
 		// calculating shading
 		sf::Color color = sf::Color::White;
@@ -526,26 +714,25 @@ void GameState::drawWalls()
 		color.g *= brightness;
 		color.b *= brightness;
 
+		// the column shows the whole height of the texture, choosing the level where a texel is about a pixel
+		int level = gpuMipmaps ? 0 : chooseMipLevel(textureSize.y / wallHeight, levels);
+		sf::Vector2f levelSize = (sf::Vector2f)members.textures.getLevel("wall", level).getSize();
+
 		// making sure the texture is the right aspect ration
-		float xMultiplier = (float)members.window.getSize().x / members.window.getSize().y;
+		float xMultiplier = (float)renderSize.x / renderSize.y;
 		// the x coord to sample from in the texture
-		int textureSizeX = members.textures["wall"].getSize().x;
+		int textureSizeX = (int)textureSize.x;
 		float textureX = (int)(textureSizeX * ray.hitCoord * xMultiplier) % textureSizeX;
+		textureX *= levelSize.x / textureSize.x;
 
-		// setting wall position and height
-		wallLines[2 * x].position = { (float)x, ceiling };
-		wallLines[2 * x + 1].position = { (float)x, floor };
-
-		// shading the wall
-		wallLines[2 * x].color = color;
-		wallLines[2 * x + 1].color = color;
-
-		// texturing the wall according to the hit coordinate
-		wallLines[2 * x].texCoords = { textureX, 0 };
-		wallLines[2 * x + 1].texCoords = { textureX, (float)members.textures["wall"].getSize().y };
+		// setting wall position and height, shading the wall and texturing it according to the hit coordinate
+		wallLines[level].append(sf::Vertex({ (float)x, ceiling }, color, { textureX, 0 }));
+		wallLines[level].append(sf::Vertex({ (float)x, floor }, color, { textureX, levelSize.y }));
 	}
 
-	members.window.draw(wallLines, &members.textures["wall"]);
+	for (int level = 0; level < levels; level++)
+		if (wallLines[level].getVertexCount() > 0)
+			scene.draw(wallLines[level], &members.textures.getLevel("wall", level));
 }
 
 void GameState::drawSprite(sf::Vector2f position, std::string texture)
@@ -564,18 +751,18 @@ void GameState::drawSprite(sf::Vector2f position, std::string texture)
 	// check angle to prevent weird stretching
 	if (distance >= 0.2f && abs(relativeAngle) < degToRad(45))
 	{
-		float height = (float)members.window.getSize().y / distance;
+		float height = (float)renderSize.y / distance;
 
 		// calculating floor and ceiling y values
-		float ceiling = (members.window.getSize().y - height) / 2.0f;
-		float floor = members.window.getSize().y - ceiling;
+		float ceiling = (renderSize.y - height) / 2.0f;
+		float floor = renderSize.y - ceiling;
 
 		// getting width of texture
 		float aspectRatio = (float)members.textures[texture].getSize().x / members.textures[texture].getSize().y;
 		float width = height * aspectRatio;
 
 		// calculating middle of texture
-		float middle = members.window.getSize().x - (relativeAngle / Player::FOV + 0.5f) * members.window.getSize().x;
+		float middle = renderSize.x - (relativeAngle / Player::FOV + 0.5f) * renderSize.x;
 
 		sf::VertexArray sprite(sf::Lines, 2 * (width + 1));
 
@@ -583,8 +770,8 @@ void GameState::drawSprite(sf::Vector2f position, std::string texture)
 		{
 			float posX = middle + (float)x - (width / 2.0f);
 
-			// if outside window or behind walls then don't draw
-			if (posX < 0 || posX > members.window.getSize().x || zBuffer[(int)posX] < distance)
+			// if outside the view or behind walls then don't draw
+			if (posX < 0 || posX > renderSize.x || zBuffer[(int)posX] < distance)
 				continue;
 
 			sf::Color color = sf::Color::White;
@@ -612,6 +799,6 @@ void GameState::drawSprite(sf::Vector2f position, std::string texture)
 			sprite[2 * x + 1].texCoords = { textureX, (float)members.textures[texture].getSize().y };
 		}
 
-		members.window.draw(sprite, &members.textures[texture]);
+		scene.draw(sprite, &members.textures[texture]);
 	}
 }
@@ -5,6 +5,14 @@
 #include "../TextureManager.hpp"
 #include "sockets.hpp"
 #include "../Members.hpp"
+#include "../InterpolationBuffer.hpp"
+#include "SlotMap.hpp"
+#include "VisibilityMap.hpp"
+#include "ReliableChannel.hpp"
+#include "../NetworkThread.hpp"
+#include "../ui/Hud.hpp"
+#include "../ui/Minimap.hpp"
+#include <deque>
 
 // Represents a casted ray.
 struct Ray
@@ -26,8 +34,9 @@ public:
 	 * @param members The members.
 	 * @param isFocused Is the window focused.
 	 * @param ip The server IP.
+	 * @param maze The maze, from the server's Start message.
 	 */
-	GameState(Members& members, bool isFocused, std::string ip);
+	GameState(Members& members, bool isFocused, std::string ip, const globals::MazeArr& maze);
 
 	/**
 	 * @brief Updates the state.
@@ -69,25 +78,76 @@ public:
 	void shootBullet();
 
 	/**
-	 * @brief Receives packets on UDP and process them.
+	 * @brief Handles the events the network thread received since the last frame.
+	 * @return Whether the game continues (if received message that says the game ended, returns false).
 	 */
-	void receiveUDP();
+	bool handleEvents();
 
 	/**
-	 * @brief Receives packets on TCP and process them.
-	 * @return Whether the game continues (if received message that says the game ended, returns false).
+	 * @brief Handles a packet from the server.
+	 * @param packet The packet.
+	 * @param time When the packet arrived.
+	 */
+	void handlePacket(const protocol::Packet& packet, std::chrono::steady_clock::time_point time);
+
+	/**
+	 * @brief Handles a message from the reliable channel.
+	 * @param message The message.
+	 * @return Whether the game continues (if the message says the game ended, returns false).
+	 */
+	bool handleMessage(const ReliableChannel::Message& message);
+
+	/**
+	 * @brief Corrects the estimated server time according to a tick received from the server.
+	 * @param tick The received server tick.
+	 * @param age How many seconds ago the tick arrived.
+	 */
+	void updateServerTick(int tick, float age);
+
+	/**
+	 * @brief Sets the positions of the other players and the bullets from their snapshots, interpolationDelay seconds in the past.
+	 */
+	void interpolateEntities();
+
+	/**
+	 * @brief Sends an input to the server (UDP).
+	 * @param input The input.
+	 * @return The input as the server decodes it (the direction and WASD rounded to their precision on the wire).
+	 */
+	PlayerInput sendInput(const PlayerInput& input);
+
+	/**
+	 * @brief Simulates the player's input in fixed steps, predicting the movement locally and sending it to the server.
+	 */
+	void processInput();
+
+	/**
+	 * @brief Corrects the predicted player position according to the server,
+	 * and replays the inputs that the server hasn't simulated yet.
+	 * @param position The position from the server.
+	 * @param lastInput The sequence of the last input the server simulated.
+	 */
+	void reconcile(sf::Vector2f position, int lastInput);
+
+	/**
+	 * @brief Moves the camera to the player that is followed when spectating.
+	 */
+	void followPlayer();
+
+	/**
+	 * @brief Follows the next player when spectating.
 	 */
-	bool receiveTCP();
+	void followNextPlayer();
 
 	/**
-	 * @brief Moves all players by a bit to their updated positions.
+	 * @brief Moves the interpolation delay towards what the connection needs: further in the past when the round trip time is jittery.
 	 */
-	void movePlayers();
+	void tuneInterpolationDelay();
 
 	/**
-	 * @brief Sends the player's position to the server (UDP).
+	 * @brief Draws the round trip time, jitter, loss and interpolation delay.
 	 */
-	void sendPosition();
+	void drawNetGraph();
 
 	/**
 	 * @brief Draws the floor and ceiling.
@@ -111,34 +171,92 @@ private:
 
 	sockets::Address serverAddressUDP;
 
+	// receives from the server, and runs the reliable channel of gameplay events
+	NetworkThread network;
+
+	// the connection quality, from the network thread
+	ReliableChannel::Stats networkStats;
+
 	globals::MazeArr maze;
 
+	// the cells that can be seen from every cell, and the ones that can be seen from the player's cell this frame
+	VisibilityMap visibility;
+	std::vector<bool> visibleCells;
+
 	sf::Clock deltaClock;
 	float dt;
 
-	const int NUMBER_OF_TICKS = 30;
+	// time that wasn't simulated yet
 	float elapsedTime;
 
+	// the most input steps to simulate in one frame
+	const int MAX_INPUT_STEPS = 5;
+
+	int inputSequence;
+	int lastAckedInput;
+
+	// inputs that were sent but not simulated by the server yet
+	std::deque<PlayerInput> pendingInputs;
+
 	int timer;
 
 	int score;
 
 	Player player;
 
-	sf::Sprite heartSprite;
-	sf::Text timerText;
-	sf::Text scoreText;
+	Hud hud;
 
-	sf::Sprite crosshair;
+	// the parts of the maze that were seen
+	Minimap minimap;
+
+	// connection quality, toggled with F3
+	sf::Text netGraphText;
+	bool showNetGraph;
+
+	// whether the GPU chooses the mip levels of the walls, floor and ceiling (toggled with F4) instead of the distance of every column and row
+	bool gpuMipmaps;
 
 	sf::Vector2i centerScreenPos;
 	bool isFocused;
 	bool paused;
 
+	// the 3D view, rendered at renderSize (the render scale of the window's size) and then stretched over the window under the HUD
+	sf::RenderTexture scene;
+	sf::Sprite sceneSprite;
+	sf::Vector2u renderSize;
+	// restarted after every display, so it measures the whole frame for the render scale
+	sf::Clock frameClock;
+
 	std::vector<float> zBuffer;
 
-	std::unordered_map<int, sf::Vector2f> bullets;
+	// estimated current server tick
+	float serverTick;
+	bool hasServerTick;
+
+	// the server tick the other players and bullets are rendered at
+	float renderTick;
+
+	// how many seconds in the past the other players and bullets are rendered
+	float interpolationDelay;
+
+	// the interpolation delay covers players that are updated every few ticks. With the round trip time it
+	// has to stay within how far back the server checks hits (globals::MAX_REWIND_TICKS), so it gets shorter when the round trip is longer than 250ms
+	const float MIN_INTERPOLATION_DELAY = 0.1f;
+	const float MAX_INTERPOLATION_DELAY = 0.25f;
+
+	// if the estimated server tick is more than this away from a received tick, jump to it
+	const float MAX_TICK_DRIFT = 30;
+
+	// columns of players and bullets
+	enum { POSITION, SNAPSHOTS, VISIBLE };
+
+	// mirror the server's handles (the index in packets)
+	SlotMap<sf::Vector2f, InterpolationBuffer> players;
+	SlotMap<sf::Vector2f, InterpolationBuffer, char> bullets;
+
+	// the newest tick the server sent bullets in
+	int lastBulletTick;
 
-	std::unordered_map<int, sf::Vector2f> players;
-	std::unordered_map<int, sf::Vector2f> targetPlayerPositions;
+	// the player the camera follows when spectating, switched with Tab
+	Handle followed;
 };
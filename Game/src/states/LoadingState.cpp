@@ -0,0 +1,41 @@
+#include "LoadingState.hpp"
+#include "MainMenuState.hpp"
+
+LoadingState::LoadingState(Members& members) : members(members)
+{
+	sf::Vector2f windowSize = (sf::Vector2f)members.window.getSize();
+	sf::Vector2f barSize = { windowSize.x / 2, windowSize.y / 30 };
+
+	barBackground.setSize(barSize);
+	barBackground.setOrigin(barSize / 2.0f);
+	barBackground.setPosition(windowSize / 2.0f);
+	barBackground.setFillColor(sf::Color(50, 50, 50));
+
+	bar.setPosition(barBackground.getPosition() - barSize / 2.0f);
+	bar.setFillColor(sf::Color::Red);
+}
+
+void LoadingState::update()
+{
+	sf::Event event;
+
+	while (members.window.pollEvent(event))
+		if (event.type == sf::Event::Closed)
+			members.manager.quit();
+
+	members.assets.update(UPLOAD_BUDGET);
+	bar.setSize({ barBackground.getSize().x * members.assets.getProgress(), barBackground.getSize().y });
+
+	if (members.assets.isDone())
+		members.manager.setState(std::make_unique<MainMenuState>(members));
+}
+
+void LoadingState::draw()
+{
+	members.window.clear(sf::Color(77, 77, 77));
+
+	members.window.draw(barBackground);
+	members.window.draw(bar);
+
+	members.window.display();
+}
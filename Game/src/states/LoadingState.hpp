@@ -0,0 +1,36 @@
+#pragma once
+
+#include "State.hpp"
+#include "../Members.hpp"
+
+/**
+ * @brief Loading state: shows a progress bar while the assets load, then goes to the main menu.
+ */
+class LoadingState : public State
+{
+public:
+	// how many seconds of every frame can be spent uploading textures
+	inline static const float UPLOAD_BUDGET = 0.004f;
+
+	/**
+	 * @brief Creates a new LoadingState object.
+	 * @param members The members.
+	 */
+	LoadingState(Members& members);
+
+	/**
+	 * @brief Updates the state.
+	 */
+	void update() override;
+
+	/**
+	 * @brief Draws the state.
+	 */
+	void draw() override;
+
+private:
+	Members& members;
+
+	sf::RectangleShape barBackground;
+	sf::RectangleShape bar;
+};
@@ -1,7 +1,7 @@
 #include "LobbyState.hpp"
 #include "GameState.hpp"
-#include "protocol.hpp"
-#include <iostream>
+#include "messages.hpp"
+#include "logging.hpp"
 
 LobbyState::LobbyState(Members& members, std::string ip)
 	: members(members), isFocused(true), ip(ip)
@@ -28,7 +28,7 @@ void LobbyState::update()
 	{
 		if (event.type == sf::Event::Closed)
 		{
-			members.tcpSocket.send(protocol::keyValueMessage("close", std::to_string(members.playerIndex)));
+			messages::send(members.tcpSocket, messages::Close{});
 			members.tcpSocket.close();
 			members.manager.quit();
 			return;
@@ -41,33 +41,34 @@ void LobbyState::update()
 
 	try
 	{
-		auto [key, value] = protocol::receiveKeyValue(members.tcpSocket);
-
-		if (key == "player") // value is new player name
-		{
-			sf::Text text;
-			text.setFont(members.font);
-			text.setCharacterSize(30);
-			text.setPosition(0, lobbyText.getGlobalBounds().height + playerNamesTexts.size() * 30 + 20);
-			text.setString(value);
-			playerNamesTexts.push_back(text);
-		}
-
-		else if (key == "index") // value is the index of the player
-			members.playerIndex = std::stoi(value);
-
-		else if (key == "start") // no value
-		{
-			std::unique_ptr<GameState> gameState = std::make_unique<GameState>(members, isFocused, ip);
-			members.manager.setState(std::move(gameState));
-		}
-
-		else if (key == "soon") // no value
-			statusText.setString("Starting!");
+		messages::dispatch(messages::receive(members.tcpSocket), messages::Handlers{
+			[&](const messages::Player& player)
+			{
+				sf::Text text;
+				text.setFont(members.font);
+				text.setCharacterSize(30);
+				text.setPosition(0, lobbyText.getGlobalBounds().height + playerNamesTexts.size() * 30 + 20);
+				text.setString(player.name);
+				playerNamesTexts.push_back(text);
+			},
+			[&](const messages::Index& index)
+			{
+				members.playerIndex = index.index;
+			},
+			[&](const messages::Start& start)
+			{
+				std::unique_ptr<GameState> gameState = std::make_unique<GameState>(members, isFocused, ip, start.maze);
+				members.manager.setState(std::move(gameState));
+			},
+			[&](const messages::Soon&)
+			{
+				statusText.setString("Starting!");
+			}
+		});
 	}
 	catch (sockets::exception& err)
 	{
-		std::cout << err.what() << std::endl;
+		logging::error("Lobby error", { { "error", err.what() } });
 	}
 }
 
@@ -1,21 +1,16 @@
 #include "MainMenuState.hpp"
-#include <iostream>
 #include "LobbyState.hpp"
 #include "sockets.hpp"
-#include "protocol.hpp"
+#include "messages.hpp"
 #include "util.hpp"
 #include "globals.hpp"
-#include <future>
-
-using namespace std::chrono_literals;
+#include "logging.hpp"
 
 MainMenuState::MainMenuState(Members& members)
 	: members(members),
 	hostButton({ members.window.getSize().x / 2.0f, members.window.getSize().y / 2.0f }, members.textures, "playButton", "playButtonPressed"),
-	nameField({ members.window.getSize().x / 2.0f, 100 }, members.font, "Name: ", 10, 30),
-	ipField({ members.window.getSize().x / 2.0f, 150 }, members.font, "IP: ", 16, 30),
-	canConnect(true),
-	doesFutureExist(false)
+	nameField({ members.window.getSize().x / 2.0f, 100 }, members.font, members.spectating ? "Token: " : "Name: ", 10, 30),
+	ipField({ members.window.getSize().x / 2.0f, 150 }, members.font, "IP: ", 39, 20)
 {
 	hostButton.setSizeRelativeToWindow(members.window, 0.2f);
 	statusText.setFont(members.font);
@@ -31,42 +26,36 @@ MainMenuState::MainMenuState(Members& members)
 	float y = logoBounds.top + logoBounds.height;
 	nameField.setPosition({ members.window.getSize().x / 2.0f, y });
 	ipField.setPosition({ members.window.getSize().x / 2.0f, y + 60 });
-}
 
-bool MainMenuState::connectToServer()
-{
-	statusText.setFillColor(sf::Color::Yellow);
-	statusText.setString("Connecting to server...");
+	// the menu still works without LAN discovery
 	try
 	{
-		members.tcpSocket.connect({ ip, globals::TCP_PORT });
+		browser.start();
 	}
 	catch (sockets::exception& err)
 	{
-		statusText.setFillColor(sf::Color::Red);
-		statusText.setString("Can't connect to server.");
-
-		std::cout << err.what() << std::endl;
-		if (std::string(err.what()) == "Socket timed out")
-			members.tcpSocket = sockets::Socket(sockets::Protocol::TCP);
-
-		return false;
+		logging::warning("Can't search for LAN servers", { { "error", err.what() } });
 	}
-	return true;
 }
 
 void MainMenuState::startConnection()
 {
 	try
 	{
-		members.tcpSocket.send(protocol::keyValueMessage("player", nameField.getText()));
-
-		// get available port
-		members.udpSocket.bind({ "0.0.0.0", 0 });
+		// spectators don't join the game, they send the server's spectator token instead (relays don't need one)
+		if (!members.spectating)
+			messages::send(members.tcpSocket, messages::Player{ nameField.getText() });
+		else if (nameField.getText() != "")
+			messages::send(members.tcpSocket, messages::Watch{ nameField.getText() });
+
+		// get available port, in the family of the server's address
+		sockets::AddressFamily family = sockets::Address{ ip }.getFamily();
+		members.udpSocket = sockets::Socket(sockets::Protocol::UDP, family);
+		members.udpSocket.bind({ family == sockets::AddressFamily::IPV6 ? "::" : "0.0.0.0", 0 });
 		sockets::Address udpAddress = members.udpSocket.getSocketName();
 
 		// send UDP port
-		members.tcpSocket.send(protocol::keyValueMessage("udp", std::to_string(udpAddress.port)));
+		messages::send(members.tcpSocket, messages::Udp{ udpAddress.port });
 
 		std::unique_ptr<LobbyState> lobbyState = std::make_unique<LobbyState>(members, ip);
 		members.manager.setState(std::move(lobbyState));
@@ -75,27 +64,37 @@ void MainMenuState::startConnection()
 	{
 		statusText.setFillColor(sf::Color::Red);
 		statusText.setString("Can't connect to server.");
-		std::cout << err.what() << std::endl;
+		logging::error("Can't connect to server", { { "error", err.what() } });
 	}
 }
 
 void MainMenuState::handleButtonPress()
 {
 	hostButton.setClicked(false);
+
+	// the closest LAN server, if no IP was entered
+	if (ipField.getText() == "" && !browser.getServers().empty())
+		ipField.setText(browser.getServers().front().address.ip);
 	ip = ipField.getText();
 
-	if (nameField.getText() == "")
+	if (nameField.getText() == "" && !members.spectating)
 	{
 		statusText.setString("Please enter a name.");
 		return;
 	}
 
-	if (canConnect)
+	// pressing again while connecting cancels
+	if (connector.getState() == sockets::Connector::State::RESOLVING || connector.getState() == sockets::Connector::State::CONNECTING)
 	{
-		connectFuture = std::async(std::launch::async, &MainMenuState::connectToServer, this);
-		canConnect = false;
-		doesFutureExist = true;
+		connector.cancel();
+		statusText.setFillColor(sf::Color::Red);
+		statusText.setString("Cancelled.");
+		return;
 	}
+
+	statusText.setFillColor(sf::Color::Yellow);
+	statusText.setString("Connecting to server...");
+	connector.start(ip, members.spectating ? globals::SPECTATOR_PORT : globals::TCP_PORT, CONNECT_TIMEOUT);
 }
 
 void MainMenuState::update()
@@ -116,6 +115,12 @@ void MainMenuState::update()
 			nameField.setFocus(nameField.contains(pos));
 			ipField.setFocus(ipField.contains(pos));
 
+			for (size_t i = 0; i < serverTexts.size(); i++)
+			{
+				if (serverTexts[i].getGlobalBounds().contains(pos))
+					ipField.setText(browser.getServers()[i].address.ip);
+			}
+
 			if (hostButton.isButtonClicked(pos))
 				handleButtonPress();
 		}
@@ -126,20 +131,50 @@ void MainMenuState::update()
 		}
 	}
 
-	// checks if connecting has answer
-	if (!doesFutureExist || connectFuture.wait_for(0s) != std::future_status::ready)
-		return;
+	if (browser.update())
+		updateServerList();
 
-	// if not connected then bad
-	bool connected = connectFuture.get();
-	if (!connected)
+	sockets::Connector::State state = connector.poll();
+	if (state == sockets::Connector::State::FAILED)
 	{
-		canConnect = true;
-		doesFutureExist = false;
-		return;
+		statusText.setFillColor(sf::Color::Red);
+		statusText.setString("Can't connect to server.");
+		logging::error("Can't connect to server", { { "error", connector.getError() } });
+
+		connector.cancel();
 	}
+	else if (state == sockets::Connector::State::CONNECTED)
+	{
+		members.tcpSocket = connector.getSocket();
+		// the server's address, for UDP (the IP field can be a host name)
+		ip = connector.getAddress().ip;
 
-	startConnection();
+		connector.cancel();
+		browser.stop();
+		startConnection();
+	}
+}
+
+void MainMenuState::updateServerList()
+{
+	const std::vector<ServerBrowser::Server>& servers = browser.getServers();
+	serverTexts.clear();
+
+	float y = members.window.getSize().y * 0.63f;
+	for (size_t i = 0; i < servers.size() && i < (size_t)MAX_LISTED_SERVERS; i++)
+	{
+		const ServerBrowser::Server& server = servers[i];
+		std::string line = server.info.name + "  " + std::to_string(server.info.players) + "/" + std::to_string(server.info.maxPlayers)
+			+ "  " + std::to_string((int)(server.rtt * 1000)) + "ms" + (server.info.started ? "  (playing)" : "");
+
+		sf::Text text;
+		text.setFont(members.font);
+		text.setCharacterSize(20);
+		text.setFillColor(server.info.started ? sf::Color(180, 180, 180) : sf::Color::White);
+		text.setString(line);
+		text.setPosition(20, y + i * 26);
+		serverTexts.push_back(text);
+	}
 }
 
 void MainMenuState::draw()
@@ -152,6 +187,9 @@ void MainMenuState::draw()
 	nameField.draw(members.window);
 	ipField.draw(members.window);
 
+	for (const sf::Text& text : serverTexts)
+		members.window.draw(text);
+
 	statusText.setOrigin(0, statusText.getCharacterSize());
 	statusText.setPosition(0, members.window.getSize().y - 10);
 	members.window.draw(statusText);
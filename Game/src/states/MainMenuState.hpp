@@ -5,7 +5,8 @@
 #include "../TextureManager.hpp"
 #include "../ui/TextField.hpp"
 #include "../Members.hpp"
-#include <future>
+#include "../ServerBrowser.hpp"
+#include "connector.hpp"
 
 /**
  * @brief Main menu state.
@@ -13,6 +14,12 @@
 class MainMenuState : public State
 {
 public:
+	// how many seconds connecting to the server can take, including resolving its name
+	inline static const float CONNECT_TIMEOUT = 5.0f;
+
+	// how many LAN servers are listed
+	inline static const int MAX_LISTED_SERVERS = 5;
+
 	/**
 	 * @brief Creates a new main menu.
 	 * @param members The members.
@@ -35,15 +42,15 @@ public:
 	void startConnection();
 
 	/**
-	 * @brief Handles button press.
+	 * @brief Handles button press: starts connecting to the server, or cancels connecting.
+	 * If no IP was entered, connects to the LAN server with the lowest round trip time.
 	 */
 	void handleButtonPress();
 
 	/**
-	 * @brief Tries connecting to the server.
-	 * @return Whether the connection succeeded.
+	 * @brief Remakes the texts of the listed LAN servers.
 	 */
-	bool connectToServer();
+	void updateServerList();
 
 private:
 	Members& members;
@@ -58,7 +65,10 @@ private:
 
 	std::string ip;
 
-	std::future<bool> connectFuture;
-	bool canConnect;
-	bool doesFutureExist;
+	// connects to the server without blocking the menu
+	sockets::Connector connector;
+
+	ServerBrowser browser;
+	// one for every listed server, clicking one puts its IP in the IP field
+	std::vector<sf::Text> serverTexts;
 };
@@ -0,0 +1,104 @@
+#include "Hud.hpp"
+#include "globals.hpp"
+
+Hud::Hud(TextureManager& textures, sf::Font& font, sf::Vector2u windowSize)
+	: heartTexture(textures["heart"]), hearts(sf::Quads), timer(0), score(0), lives(0), playerShown(true),
+	heartsDirty(true), timerDirty(true), scoreDirty(true)
+{
+	float heartHeight = (float)heartTexture.getSize().y;
+
+	timerText.setFont(font);
+	timerText.setPosition(0, heartHeight);
+	timerText.setCharacterSize((unsigned int)heartHeight);
+
+	scoreText.setFont(font);
+	scoreText.setCharacterSize((unsigned int)heartHeight);
+	scoreText.setPosition(0, 2 * heartHeight);
+
+	crosshair.setTexture(textures["crosshair"]);
+	crosshair.setOrigin(crosshair.getLocalBounds().getSize() / 2.0f);
+	crosshair.setPosition(windowSize.x / 2.0f, windowSize.y / 2.0f);
+}
+
+void Hud::setTimer(int seconds)
+{
+	if (seconds == timer)
+		return;
+	timer = seconds;
+	timerDirty = true;
+}
+
+void Hud::setScore(int points)
+{
+	if (points == score)
+		return;
+	score = points;
+	scoreDirty = true;
+}
+
+void Hud::setLives(int lives)
+{
+	if (lives == this->lives)
+		return;
+	this->lives = lives;
+	heartsDirty = true;
+}
+
+void Hud::setPlayerShown(bool shown)
+{
+	playerShown = shown;
+}
+
+void Hud::draw(sf::RenderTarget& target)
+{
+	if (heartsDirty)
+		layoutHearts();
+	if (timerDirty)
+		layoutTimer();
+	if (scoreDirty)
+	{
+		scoreText.setString(std::to_string(score));
+		scoreDirty = false;
+	}
+
+	if (playerShown && hearts.getVertexCount() > 0)
+		target.draw(hearts, &heartTexture);
+
+	target.draw(timerText);
+
+	if (playerShown)
+		target.draw(scoreText);
+
+	target.draw(crosshair);
+}
+
+void Hud::layoutHearts()
+{
+	sf::Vector2f size = (sf::Vector2f)heartTexture.getSize();
+
+	hearts.clear();
+	for (int i = 0; i < lives; i++)
+	{
+		float left = i * size.x;
+		hearts.append(sf::Vertex({ left, 0 }, { 0, 0 }));
+		hearts.append(sf::Vertex({ left + size.x, 0 }, { size.x, 0 }));
+		hearts.append(sf::Vertex({ left + size.x, size.y }, { size.x, size.y }));
+		hearts.append(sf::Vertex({ left, size.y }, { 0, size.y }));
+	}
+
+	heartsDirty = false;
+}
+
+void Hud::layoutTimer()
+{
+	// pad seconds with zeros
+	int seconds = timer % 60;
+	timerText.setString(std::to_string(timer / 60) + (seconds < 10 ? ":0" : ":") + std::to_string(seconds));
+
+	sf::Color timerColor;
+	timerColor.g = (int)((255.0f / globals::GAME_TIME) * timer);
+	timerColor.r = 255 - timerColor.g;
+	timerText.setFillColor(timerColor);
+
+	timerDirty = false;
+}
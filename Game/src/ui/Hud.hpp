@@ -0,0 +1,78 @@
+#pragma once
+#include "SFML/Graphics.hpp"
+#include "../TextureManager.hpp"
+
+/**
+ * @brief The HUD over the 3D view: the hearts, the timer, the score and the crosshair.
+ * It's retained: the setters only mark what changed, and draw lays out the texts and the hearts again only then,
+ * so the glyph geometry of the texts isn't rebuilt every frame. All the hearts are one batch of quads.
+ */
+class Hud
+{
+public:
+	/**
+	 * @brief Creates a new Hud object.
+	 * @param textures The texture manager.
+	 * @param font The font.
+	 * @param windowSize The size of the window.
+	 */
+	Hud(TextureManager& textures, sf::Font& font, sf::Vector2u windowSize);
+
+	/**
+	 * @brief Sets the time left.
+	 * @param seconds The time left in seconds.
+	 */
+	void setTimer(int seconds);
+
+	/**
+	 * @brief Sets the score.
+	 * @param points The score.
+	 */
+	void setScore(int points);
+
+	/**
+	 * @brief Sets how many hearts are shown.
+	 * @param lives The lives.
+	 */
+	void setLives(int lives);
+
+	/**
+	 * @brief Sets whether the hearts and the score are shown (spectators have neither).
+	 * @param shown Whether they are shown.
+	 */
+	void setPlayerShown(bool shown);
+
+	/**
+	 * @brief Draws the HUD, laying out the parts that changed first.
+	 * @param target Where to draw.
+	 */
+	void draw(sf::RenderTarget& target);
+
+private:
+	/**
+	 * @brief Builds the quads of the hearts.
+	 */
+	void layoutHearts();
+
+	/**
+	 * @brief Sets the string and color of the timer.
+	 */
+	void layoutTimer();
+
+	sf::Texture& heartTexture;
+	sf::VertexArray hearts;
+
+	sf::Text timerText;
+	sf::Text scoreText;
+
+	sf::Sprite crosshair;
+
+	int timer;
+	int score;
+	int lives;
+	bool playerShown;
+
+	bool heartsDirty;
+	bool timerDirty;
+	bool scoreDirty;
+};
@@ -0,0 +1,73 @@
+#include "Minimap.hpp"
+#include <cmath>
+
+Minimap::Minimap(const globals::MazeArr& maze)
+	: maze(maze), revealed(globals::WORLD_WIDTH * globals::WORLD_HEIGHT, false), playerMarker(CELL_SIZE / 2.0f, 3)
+{
+	if (!map.create(globals::WORLD_WIDTH * CELL_SIZE, globals::WORLD_HEIGHT * CELL_SIZE))
+		throw std::exception("ERROR: Can't create the render texture of the minimap.");
+
+	// unexplored cells stay transparent
+	map.clear(sf::Color::Transparent);
+	map.display();
+	mapSprite.setTexture(map.getTexture());
+
+	background.setSize((sf::Vector2f)map.getSize());
+	background.setFillColor(sf::Color(0, 0, 0, 150));
+
+	playerMarker.setOrigin(playerMarker.getRadius(), playerMarker.getRadius());
+	playerMarker.setFillColor(sf::Color::Red);
+}
+
+void Minimap::reveal(sf::Vector2i cell)
+{
+	if (cell.x < 0 || cell.x >= globals::WORLD_WIDTH || cell.y < 0 || cell.y >= globals::WORLD_HEIGHT)
+		return;
+
+	int index = cell.y * globals::WORLD_WIDTH + cell.x;
+	if (revealed[index])
+		return;
+
+	revealed[index] = true;
+	newCells.push_back(cell);
+}
+
+void Minimap::update()
+{
+	if (newCells.empty())
+		return;
+
+	// one quad for every new cell, drawn over what's already in the map
+	sf::VertexArray cells(sf::Quads, 4 * newCells.size());
+	for (size_t i = 0; i < newCells.size(); i++)
+	{
+		sf::Vector2f corner = (sf::Vector2f)(newCells[i] * CELL_SIZE);
+		sf::Color color = maze[newCells[i].y][newCells[i].x] == globals::CELL_WALL ? sf::Color(200, 200, 200) : sf::Color(60, 60, 60);
+
+		cells[4 * i] = sf::Vertex(corner, color);
+		cells[4 * i + 1] = sf::Vertex(corner + sf::Vector2f((float)CELL_SIZE, 0), color);
+		cells[4 * i + 2] = sf::Vertex(corner + sf::Vector2f((float)CELL_SIZE, (float)CELL_SIZE), color);
+		cells[4 * i + 3] = sf::Vertex(corner + sf::Vector2f(0, (float)CELL_SIZE), color);
+	}
+
+	map.draw(cells);
+	map.display();
+	newCells.clear();
+}
+
+void Minimap::draw(sf::RenderTarget& target, sf::Vector2f position, float direction)
+{
+	sf::Vector2f mapSize = (sf::Vector2f)map.getSize();
+	sf::Vector2f corner = (sf::Vector2f)target.getSize() - mapSize - sf::Vector2f(MARGIN, MARGIN);
+
+	background.setPosition(corner);
+	target.draw(background);
+
+	mapSprite.setPosition(corner);
+	target.draw(mapSprite);
+
+	// the triangle's tip points where the player looks
+	playerMarker.setPosition(corner + position * (float)CELL_SIZE);
+	playerMarker.setRotation(direction * 180 / (float)M_PI + 90);
+	target.draw(playerMarker);
+}
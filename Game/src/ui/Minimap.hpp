@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "SFML/Graphics.hpp"
+#include "globals.hpp"
+
+/**
+ * @brief A top-down map of the maze, showing only the cells the player has seen and where the player is.
+ * The map is kept in a render texture that is never cleared: cells are revealed by the wall raycasts,
+ * and every frame only the cells revealed since the last frame are drawn into it.
+ */
+class Minimap
+{
+public:
+	// how many pixels every cell takes on the map
+	inline static const int CELL_SIZE = 8;
+
+	// how far the map is from the corner of the window
+	inline static const float MARGIN = 10;
+
+	/**
+	 * @brief Creates a new Minimap object with nothing revealed.
+	 * @param maze The maze, which must outlive the map.
+	 */
+	Minimap(const globals::MazeArr& maze);
+
+	/**
+	 * @brief Reveals a cell. Cheap for cells that were already revealed, so it can be called for every cell a ray passes.
+	 * @param cell The cell. Cells outside the maze are ignored.
+	 */
+	void reveal(sf::Vector2i cell);
+
+	/**
+	 * @brief Draws the cells revealed since the last update into the map.
+	 */
+	void update();
+
+	/**
+	 * @brief Draws the map in the bottom right corner of a target, with the player on it.
+	 * @param target Where to draw.
+	 * @param position The player's position.
+	 * @param direction The player's direction in radians.
+	 */
+	void draw(sf::RenderTarget& target, sf::Vector2f position, float direction);
+
+private:
+	const globals::MazeArr& maze;
+
+	// the revealed cells, indexed by y * WORLD_WIDTH + x
+	std::vector<bool> revealed;
+	// cells that were revealed but aren't drawn into the map yet
+	std::vector<sf::Vector2i> newCells;
+
+	sf::RenderTexture map;
+	sf::Sprite mapSprite;
+	sf::RectangleShape background;
+	sf::CircleShape playerMarker;
+};
@@ -23,6 +23,12 @@ std::string TextField::getText() const
 	return currentText;
 }
 
+void TextField::setText(const std::string& newText)
+{
+	currentText = newText.substr(0, maxSize);
+	text.setString(defaultText + currentText);
+}
+
 bool TextField::contains(sf::Vector2f pos)
 {
 	return rect.getGlobalBounds().contains(pos);
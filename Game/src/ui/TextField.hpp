@@ -23,6 +23,12 @@ public:
 	 */
 	std::string getText() const;
 
+	/**
+	 * @brief Sets the text of the field.
+	 * @param newText The text, cut to the maximum number of characters.
+	 */
+	void setText(const std::string& newText);
+
 	/**
 	 * @brief Checks if a position is inside the field.
 	 * @param pos The position.
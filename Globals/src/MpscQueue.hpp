@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <cstddef>
+
+/**
+ * @brief A bounded lock-free queue with many producers and one consumer.
+ * Every slot has a sequence number that tells whether it is free to write or ready to read,
+ * so producers only contend on the tail and never wait for each other.
+ * @tparam T The type of the elements.
+ */
+template<typename T> class MpscQueue
+{
+public:
+	/**
+	 * @brief Creates a new MpscQueue object.
+	 * @param capacity How many elements the queue can hold. Rounded up to a power of 2.
+	 */
+	MpscQueue(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size *= 2;
+
+		mask = size - 1;
+		slots = std::make_unique<Slot[]>(size);
+		for (size_t i = 0; i < size; i++)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Pushes an element. Can be called from any thread.
+	 * @param value The element.
+	 * @return Whether the element was pushed, false if the queue is full.
+	 */
+	bool push(T value)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Slot& slot = slots[position & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+			if (difference == 0)
+			{
+				// the slot is free, try to claim it
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					slot.value = std::move(value);
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Pops an element. Must only be called from the consumer thread.
+	 * @return The element, or nothing if the queue is empty.
+	 */
+	std::optional<T> pop()
+	{
+		Slot& slot = slots[head & mask];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != head + 1)
+			return std::nullopt;
+
+		std::optional<T> value = std::move(slot.value);
+		// the slot can be written again when the tail wraps around to it
+		slot.sequence.store(head + mask + 1, std::memory_order_release);
+		head++;
+		return value;
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask;
+
+	// producers and the consumer are on different cache lines
+	alignas(64) std::atomic<size_t> tail = 0;
+	alignas(64) size_t head = 0;
+};
@@ -48,3 +48,15 @@ void Player::move()
 {
 	pos += velocity;
 }
+
+void Player::applyInput(const PlayerInput& input, const globals::MazeArr& maze)
+{
+	direction = input.direction;
+	calculateVelocity(input.wasd, INPUT_STEP);
+	checkCollision(maze);
+	move();
+
+	// keep the position at the precision of UPDATE_PLAYER, so the server's position is exactly the client's prediction
+	pos.x = lroundf(pos.x * globals::POSITION_SCALE) / globals::POSITION_SCALE;
+	pos.y = lroundf(pos.y * globals::POSITION_SCALE) / globals::POSITION_SCALE;
+}
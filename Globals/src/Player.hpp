@@ -4,6 +4,16 @@
 #include "util.hpp"
 #include "SFML/System/Vector2.hpp"
 
+/**
+ * @brief One fixed step of player input, sent from the client to the server.
+ */
+struct PlayerInput
+{
+	int sequence = 0;
+	sf::Vector2f wasd;
+	float direction = 0;
+};
+
 struct Player
 {
 	/**
@@ -30,11 +40,23 @@ struct Player
 	 */
 	void move();
 
+	/**
+	 * @brief Simulates one input step (direction, velocity, collision and movement).
+	 * Both the server and the client's prediction use this so they stay in sync.
+	 * @param input The input.
+	 * @param maze The maze.
+	 */
+	void applyInput(const PlayerInput& input, const globals::MazeArr& maze);
+
 
 	inline static const float FOV = degToRad(60);
 	inline static const float SPEED = 2.0f;
 	inline static const float SENSITIVITY = 0.005f;
 
+	// how many input steps are simulated per second
+	inline static const int INPUT_TICKS = 60;
+	inline static const float INPUT_STEP = 1.0f / INPUT_TICKS;
+
 
 	sf::Vector2f pos;
 	sf::Vector2f velocity;
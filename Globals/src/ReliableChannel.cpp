@@ -0,0 +1,309 @@
+#include "ReliableChannel.hpp"
+#include "serialization.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <tuple>
+#include <cmath>
+
+// how many sent packets are remembered for acks
+static const int MAX_SENT_PACKETS = 64;
+
+// how many sent packets are remembered for loss, older ones count as lost
+static const int MAX_UNACKED_PACKETS = 256;
+
+// how much a new sample changes the loss (about the last 20 packets)
+static const float LOSS_SMOOTHING = 0.05f;
+
+ReliableChannel::ReliableChannel(clock::time_point start) : start(start) {}
+
+bool ReliableChannel::send(const Message& message, bool ordered)
+{
+	// it would never fit in a packet, and would hold back every ordered message after it
+	if ((int)message.size() > MAX_MESSAGE_SIZE)
+	{
+		logging::error("Reliable message is too big", { { "size", std::to_string(message.size()) } });
+		return false;
+	}
+
+	uint32_t id = ordered ? nextOrderedId++ : nextUnorderedId++;
+	pending.push_back({ message, id, ordered, false, {} });
+	return true;
+}
+
+std::vector<char> ReliableChannel::writePacket(clock::time_point now)
+{
+	SentPacket sentPacket = { nextSequence, {} };
+	serialization::Writer messages;
+	int size = 0;
+
+	// the other side may still miss the oldest messages that weren't acked, and drops messages too far after them
+	uint32_t oldestOrderedId = nextOrderedId, oldestUnorderedId = nextUnorderedId;
+	for (auto message = pending.rbegin(); message != pending.rend(); message++)
+		(message->ordered ? oldestOrderedId : oldestUnorderedId) = message->id;
+
+	for (PendingMessage& message : pending)
+	{
+		if (message.sent && now - message.lastSent < resendDelay())
+			continue;
+
+		if (message.id - (message.ordered ? oldestOrderedId : oldestUnorderedId) >= RECEIVE_WINDOW)
+			continue;
+
+		// smaller messages after it might still fit
+		int messageSize = (int)message.message.size() + MESSAGE_OVERHEAD;
+		if (size + messageSize > MAX_PAYLOAD_SIZE)
+			continue;
+		size += messageSize;
+
+		messages.writeByte(message.ordered);
+		messages.writeVarint(message.id);
+		messages.writeVarint((uint32_t)message.message.size());
+		messages.writeBytes(message.message);
+
+		message.sent = true;
+		message.lastSent = now;
+		sentPacket.messages.push_back({ message.ordered, message.id });
+	}
+
+	if (sentPacket.messages.empty() && !ackPending && now - lastPacketSent < PING_INTERVAL)
+		return {};
+
+	uint32_t sequence = nextSequence++;
+
+	serialization::Writer writer;
+	writer.writeVarint(sequence);
+	writer.writeVarint(remoteSequence);
+	writer.writeVarint(receivedBits);
+
+	// ping, and echo of the other side's ping with how long it waited here
+	writer.writeVarint(timestamp(now));
+	writer.writeVarint(remotePing);
+	writer.writeVarint(remotePing != 0 ? timestamp(now) - timestamp(remotePingReceived) : 0);
+
+	writer.writeVarint((uint32_t)sentPacket.messages.size());
+	writer.writeBytes(messages.getData());
+
+	ackPending = false;
+	remotePing = 0;
+	lastPacketSent = now;
+
+	unackedPackets.push_back({ sequence, false });
+	if (unackedPackets.size() > MAX_UNACKED_PACKETS)
+	{
+		stats.loss += ((unackedPackets.front().second ? 0.0f : 1.0f) - stats.loss) * LOSS_SMOOTHING;
+		unackedPackets.pop_front();
+	}
+
+	if (!sentPacket.messages.empty())
+	{
+		sentPackets.push_back(std::move(sentPacket));
+		// messages of packets that are too old to be acked are sent again after RESEND_DELAY anyway
+		if (sentPackets.size() > MAX_SENT_PACKETS)
+			sentPackets.pop_front();
+	}
+
+	return writer.getData();
+}
+
+bool ReliableChannel::readPacket(const std::vector<char>& payload, clock::time_point now)
+{
+	serialization::Reader reader(payload.data(), (int)payload.size());
+
+	uint32_t sequence = reader.readVarint();
+	uint32_t ack = reader.readVarint();
+	uint32_t ackBits = reader.readVarint();
+	uint32_t ping = reader.readVarint();
+	uint32_t echo = reader.readVarint();
+	uint32_t hold = reader.readVarint();
+	uint32_t count = reader.readVarint();
+
+	std::vector<std::tuple<Message, uint32_t, bool>> messages;
+	for (uint32_t i = 0; i < count && !reader.failed(); i++)
+	{
+		bool ordered = reader.readByte() != 0;
+		uint32_t id = reader.readVarint();
+		uint32_t size = reader.readVarint();
+		messages.push_back({ reader.readBytes((int)size), id, ordered });
+	}
+
+	if (reader.failed() || !reader.atEnd() || sequence == 0)
+		return false;
+
+	// a packet with a message too far ahead isn't acked, so the message is sent again when the window gets to it
+	bool inWindow = std::all_of(messages.begin(), messages.end(), [this](const auto& message)
+	{
+		return inReceiveWindow(std::get<1>(message), std::get<2>(message));
+	});
+
+	// remember which packets were received, to ack them
+	if (inWindow)
+	{
+		if (sequence > remoteSequence)
+		{
+			uint32_t shift = sequence - remoteSequence;
+			receivedBits = shift > ACK_BITS ? 0 : (uint32_t)(((uint64_t)receivedBits << shift) | (remoteSequence != 0 ? 1ull << (shift - 1) : 0));
+			remoteSequence = sequence;
+		}
+		else if (sequence < remoteSequence && remoteSequence - sequence <= ACK_BITS)
+			receivedBits |= 1u << (remoteSequence - sequence - 1);
+
+		if (!messages.empty())
+			ackPending = true;
+	}
+
+	remotePing = ping + 1;
+	remotePingReceived = now;
+
+	// the round trip time is how long ago the echoed ping was sent, without the time it waited on the other side
+	if (echo != 0)
+	{
+		int64_t rtt = (int64_t)timestamp(now) - (echo - 1) - hold;
+		if (rtt >= 0)
+			updateRtt(rtt / 1000.0f);
+	}
+
+	// acks
+	if (ack != 0)
+	{
+		acknowledge(ack);
+		for (int i = 0; i < ACK_BITS; i++)
+		{
+			if ((ackBits & (1u << i)) && ack > (uint32_t)i + 1)
+				acknowledge(ack - i - 1);
+		}
+		updateLoss(ack);
+	}
+
+	for (auto& [message, id, ordered] : messages)
+	{
+		if (inReceiveWindow(id, ordered))
+			deliver(std::move(message), id, ordered);
+	}
+
+	return true;
+}
+
+bool ReliableChannel::receive(Message& message)
+{
+	if (received.empty())
+		return false;
+
+	message = std::move(received.front());
+	received.pop_front();
+	return true;
+}
+
+const ReliableChannel::Stats& ReliableChannel::getStats() const
+{
+	return stats;
+}
+
+void ReliableChannel::acknowledge(uint32_t sequence)
+{
+	if (!unackedPackets.empty() && sequence >= unackedPackets.front().first)
+	{
+		uint32_t index = sequence - unackedPackets.front().first;
+		if (index < unackedPackets.size())
+			unackedPackets[index].second = true;
+	}
+
+	for (auto packet = sentPackets.begin(); packet != sentPackets.end(); packet++)
+	{
+		if (packet->sequence != sequence)
+			continue;
+
+		for (auto [ordered, id] : packet->messages)
+		{
+			for (auto message = pending.begin(); message != pending.end(); message++)
+			{
+				if (message->ordered == ordered && message->id == id)
+				{
+					pending.erase(message);
+					break;
+				}
+			}
+		}
+
+		sentPackets.erase(packet);
+		return;
+	}
+}
+
+void ReliableChannel::updateLoss(uint32_t ack)
+{
+	// packets up to the ack that aren't in its bitfield were lost (or arrived very out of order)
+	while (!unackedPackets.empty() && unackedPackets.front().first <= ack)
+	{
+		stats.loss += ((unackedPackets.front().second ? 0.0f : 1.0f) - stats.loss) * LOSS_SMOOTHING;
+		unackedPackets.pop_front();
+	}
+}
+
+void ReliableChannel::updateRtt(float sample)
+{
+	// like TCP (RFC 6298)
+	if (!stats.measured)
+	{
+		stats.rtt = sample;
+		stats.jitter = sample / 2;
+		stats.measured = true;
+		return;
+	}
+
+	stats.jitter = 0.75f * stats.jitter + 0.25f * fabsf(stats.rtt - sample);
+	stats.rtt = 0.875f * stats.rtt + 0.125f * sample;
+}
+
+ReliableChannel::clock::duration ReliableChannel::resendDelay() const
+{
+	if (!stats.measured)
+		return RESEND_DELAY;
+
+	std::chrono::duration<float> timeout(stats.rtt + 4 * stats.jitter);
+	return std::chrono::duration_cast<clock::duration>(timeout) + ACK_DELAY;
+}
+
+uint32_t ReliableChannel::timestamp(clock::time_point time) const
+{
+	return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(time - start).count();
+}
+
+bool ReliableChannel::inReceiveWindow(uint32_t id, bool ordered) const
+{
+	// older ids are duplicates, which are dropped when they are delivered
+	uint32_t first = ordered ? nextReceivedOrderedId : unorderedComplete;
+	return id < first || id - first < RECEIVE_WINDOW;
+}
+
+void ReliableChannel::deliver(Message message, uint32_t id, bool ordered)
+{
+	if (ordered)
+	{
+		// already received
+		if (id < nextReceivedOrderedId)
+			return;
+
+		earlyMessages.emplace(id, std::move(message));
+
+		// receive every message that has all the messages before it
+		for (auto next = earlyMessages.find(nextReceivedOrderedId); next != earlyMessages.end(); next = earlyMessages.find(nextReceivedOrderedId))
+		{
+			received.push_back(std::move(next->second));
+			earlyMessages.erase(next);
+			nextReceivedOrderedId++;
+		}
+		return;
+	}
+
+	// already received (a message that is resent late must still arrive, however many newer ones overtook it),
+	// readPacket only delivers ids in the window so each one has its own bit
+	if (id < unorderedComplete || unorderedReceived[id % RECEIVE_WINDOW])
+		return;
+	unorderedReceived[id % RECEIVE_WINDOW] = true;
+
+	// free the bits once all the ids before them arrived
+	while (unorderedReceived[unorderedComplete % RECEIVE_WINDOW])
+		unorderedReceived[unorderedComplete++ % RECEIVE_WINDOW] = false;
+
+	received.push_back(std::move(message));
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reliable messages on top of UDP packets.
+ * Every packet has a sequence number, and acks the last packets received from the other side (the newest sequence and a bitfield of the ones before it).
+ * A message is sent again if the packets it was in weren't acked after RESEND_DELAY.
+ * Ordered messages are received in the order they were sent, unordered messages as soon as they arrive.
+ * All waiting messages are coalesced into one packet every time writePacket is called.
+ * Every packet also carries a ping timestamp and echoes the last one received, which measures the round trip time of the connection.
+ */
+class ReliableChannel
+{
+public:
+	/**
+	 * @brief A message, encoded with messages::encode.
+	 */
+	using Message = std::vector<char>;
+
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief The quality of the connection, as measured by this side.
+	 */
+	struct Stats
+	{
+		// smoothed round trip time in seconds
+		float rtt = 0;
+		// smoothed deviation of the round trip time in seconds
+		float jitter = 0;
+		// the part of the packets sent by this side that were lost (between 0 and 1)
+		float loss = 0;
+		// whether the round trip time was measured yet
+		bool measured = false;
+	};
+
+	// the most bytes of messages in one packet
+	inline static const int MAX_PAYLOAD_SIZE = 1024;
+
+	// a message takes at most this many bytes more than its data
+	inline static const int MESSAGE_OVERHEAD = 16;
+
+	// the biggest message that fits in a packet, bigger ones can't be sent
+	inline static const int MAX_MESSAGE_SIZE = MAX_PAYLOAD_SIZE - MESSAGE_OVERHEAD;
+
+	// how long to wait for an ack before sending a message again, until the round trip time is measured
+	inline static const std::chrono::milliseconds RESEND_DELAY{ 100 };
+
+	// packets are acked at most this long after they arrive (the other side writes once per tick or frame)
+	inline static const std::chrono::milliseconds ACK_DELAY{ 20 };
+
+	// a packet is written at least this often, even without messages, so the round trip time keeps being measured
+	inline static const std::chrono::milliseconds PING_INTERVAL{ 100 };
+
+	// how many packets before the newest one an ack covers
+	inline static const int ACK_BITS = 32;
+
+	// messages this many ids or more after the first one that didn't arrive yet are dropped (and their packet isn't acked),
+	// so the messages held back never take more than this many ids, and the sender never sends that far ahead
+	inline static const uint32_t RECEIVE_WINDOW = 1024;
+
+	/**
+	 * @brief Creates a new ReliableChannel object.
+	 * @param start The time the channel starts at. Tests on a simulated clock pass its start, and the same clock's times to writePacket and readPacket.
+	 */
+	ReliableChannel(clock::time_point start = clock::now());
+
+	/**
+	 * @brief Queues a message to be sent in the next packets until it is acked.
+	 * @param message The message.
+	 * @param ordered Whether the message must be received after all the ordered messages sent before it.
+	 * @return Whether the message was queued, false if it is bigger than MAX_MESSAGE_SIZE.
+	 */
+	bool send(const Message& message, bool ordered = true);
+
+	/**
+	 * @brief Writes a packet with the messages that need to be sent (new ones, and ones that weren't acked in time) and the acks.
+	 * @param now The current time.
+	 * @return The payload of the packet, or an empty vector if there is nothing to send.
+	 */
+	std::vector<char> writePacket(clock::time_point now = clock::now());
+
+	/**
+	 * @brief Reads a packet from the other side: acks the messages it acks, and queues the messages in it to be received.
+	 * @param payload The payload of the packet.
+	 * @param now The current time.
+	 * @return Whether the payload was valid.
+	 */
+	bool readPacket(const std::vector<char>& payload, clock::time_point now = clock::now());
+
+	/**
+	 * @brief Pops a received message.
+	 * @param message Set to the message.
+	 * @return Whether there was a message to receive.
+	 */
+	bool receive(Message& message);
+
+	/**
+	 * @brief Returns the quality of the connection.
+	 * @return The round trip time, jitter and loss.
+	 */
+	const Stats& getStats() const;
+
+private:
+	struct PendingMessage
+	{
+		Message message;
+		uint32_t id;
+		bool ordered;
+		bool sent;
+		std::chrono::steady_clock::time_point lastSent;
+	};
+
+	struct SentPacket
+	{
+		uint32_t sequence;
+		// (ordered, id) of every message in the packet
+		std::vector<std::pair<bool, uint32_t>> messages;
+	};
+
+	/**
+	 * @brief Removes the messages of a sent packet from the pending messages.
+	 * @param sequence The sequence of the packet.
+	 */
+	void acknowledge(uint32_t sequence);
+
+	/**
+	 * @brief Counts the sent packets up to the newest ack as lost or delivered.
+	 * @param ack The newest ack received.
+	 */
+	void updateLoss(uint32_t ack);
+
+	/**
+	 * @brief Adds a round trip time sample.
+	 * @param sample The round trip time in seconds.
+	 */
+	void updateRtt(float sample);
+
+	/**
+	 * @brief Returns how long to wait for an ack before sending a message again.
+	 * @return The delay.
+	 */
+	clock::duration resendDelay() const;
+
+	/**
+	 * @brief Returns the time in milliseconds since the channel was created, used for ping timestamps.
+	 * @param time The time.
+	 * @return The timestamp.
+	 */
+	uint32_t timestamp(clock::time_point time) const;
+
+	/**
+	 * @brief Checks if a message is in the receive window: not more than RECEIVE_WINDOW ids after the first one that didn't arrive yet.
+	 * @param id The id of the message.
+	 * @param ordered Whether the message is ordered.
+	 * @return Whether the message can be received.
+	 */
+	bool inReceiveWindow(uint32_t id, bool ordered) const;
+
+	/**
+	 * @brief Handles a received message, dropping duplicates and holding ordered messages that arrived early.
+	 * @param message The message.
+	 * @param id The id of the message.
+	 * @param ordered Whether the message is ordered.
+	 */
+	void deliver(Message message, uint32_t id, bool ordered);
+
+	// sending: sequence 0 is never used, so an ack of 0 means nothing was received
+	uint32_t nextSequence = 1;
+	uint32_t nextOrderedId = 0;
+	uint32_t nextUnorderedId = 0;
+	std::deque<PendingMessage> pending;
+	// packets with messages that weren't acked yet
+	std::deque<SentPacket> sentPackets;
+	// every sent packet that wasn't counted for loss yet, and whether it was acked
+	std::deque<std::pair<uint32_t, bool>> unackedPackets;
+	clock::time_point lastPacketSent;
+
+	// receiving
+	uint32_t remoteSequence = 0;
+	uint32_t receivedBits = 0;
+	// whether a packet with messages arrived since the last packet was written
+	bool ackPending = false;
+
+	uint32_t nextReceivedOrderedId = 0;
+	std::map<uint32_t, Message> earlyMessages;
+
+	// unordered ids received: every id below unorderedComplete, and the ones in the window above it that arrived early,
+	// each at its id % RECEIVE_WINDOW
+	uint32_t unorderedComplete = 0;
+	std::bitset<RECEIVE_WINDOW> unorderedReceived;
+
+	std::deque<Message> received;
+
+	// ping timestamps
+	clock::time_point start;
+	// the newest ping received + 1, 0 if there is no ping to echo
+	uint32_t remotePing = 0;
+	clock::time_point remotePingReceived;
+
+	Stats stats;
+};
@@ -0,0 +1,284 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+
+/**
+ * @brief A stable reference to an element in a SlotMap.
+ * The generation changes every time a slot is reused, so handles to removed elements are detected.
+ */
+struct Handle
+{
+	int index = -1;
+	int generation = 0;
+
+	// how many bits of an ID are the index
+	inline static const int INDEX_BITS = 10;
+	inline static const int MAX_INDEX = (1 << INDEX_BITS) - 1;
+
+	/**
+	 * @brief Packs the handle into one integer, to send it over the network.
+	 * @return The packed handle.
+	 */
+	int toID() const
+	{
+		return index | (generation << INDEX_BITS);
+	}
+
+	/**
+	 * @brief Unpacks a handle from an integer.
+	 * @param id The packed handle.
+	 * @return The handle.
+	 */
+	static Handle fromID(int id)
+	{
+		return { id & MAX_INDEX, (int)((uint32_t)id >> INDEX_BITS) };
+	}
+};
+
+/**
+ * @brief Checks if two handles are equal.
+ * @param handle1 First handle.
+ * @param handle2 Second handle.
+ * @return Whether the handles are equal.
+ */
+inline bool operator==(const Handle& handle1, const Handle& handle2)
+{
+	return handle1.index == handle2.index && handle1.generation == handle2.generation;
+}
+
+/**
+ * @brief A container of elements with stable handles. Every column is stored in its own dense array (structure of arrays),
+ * so iterating over one column is linear over contiguous memory.
+ * Removing an element moves the last element to its place, so the order of elements isn't kept.
+ * @tparam Columns The types of the columns.
+ */
+template<typename... Columns> class SlotMap
+{
+public:
+	/**
+	 * @brief Adds an element.
+	 * @param values The value of every column.
+	 * @return The handle of the new element, or an invalid handle (index -1) if there are no free slots.
+	 */
+	Handle insert(Columns... values)
+	{
+		int slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (slots.size() <= Handle::MAX_INDEX)
+		{
+			slot = (int)slots.size();
+			slots.push_back({ 0, -1 });
+		}
+		else
+			return {};
+
+		pushDense(slot, std::move(values)...);
+		return { slot, slots[slot].generation };
+	}
+
+	/**
+	 * @brief Adds an element with a specific handle (used to mirror a SlotMap on another machine).
+	 * If the slot has an element with a different generation, it is replaced.
+	 * @param handle The handle.
+	 * @param values The value of every column.
+	 * @return Whether the element was added (false if the handle is invalid or already exists).
+	 */
+	bool insertAt(Handle handle, Columns... values)
+	{
+		if (handle.index < 0 || handle.index > Handle::MAX_INDEX)
+			return false;
+
+		while ((int)slots.size() <= handle.index)
+		{
+			freeSlots.push_back((int)slots.size());
+			slots.push_back({ 0, -1 });
+		}
+
+		Slot& slot = slots[handle.index];
+		if (slot.dense != -1)
+		{
+			if (slot.generation == handle.generation)
+				return false;
+			remove({ handle.index, slot.generation });
+		}
+
+		// take the slot out of the free list
+		for (int i = 0; i < (int)freeSlots.size(); i++)
+		{
+			if (freeSlots[i] == handle.index)
+			{
+				freeSlots[i] = freeSlots.back();
+				freeSlots.pop_back();
+				break;
+			}
+		}
+
+		slots[handle.index].generation = handle.generation;
+		pushDense(handle.index, std::move(values)...);
+		return true;
+	}
+
+	/**
+	 * @brief Removes an element.
+	 * @param handle The handle of the element.
+	 * @return Whether the element existed.
+	 */
+	bool remove(Handle handle)
+	{
+		int dense = denseIndex(handle);
+		if (dense == -1)
+			return false;
+
+		// move the last element to the removed element's place
+		int last = size() - 1;
+		if (dense != last)
+		{
+			std::apply([dense, last](auto&... column) { ((column[dense] = std::move(column[last])), ...); }, columns);
+			denseToSlot[dense] = denseToSlot[last];
+			slots[denseToSlot[dense]].dense = dense;
+		}
+
+		std::apply([](auto&... column) { (column.pop_back(), ...); }, columns);
+		denseToSlot.pop_back();
+
+		slots[handle.index].dense = -1;
+		slots[handle.index].generation++;
+		freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	/**
+	 * @brief Allocates memory for elements ahead of time.
+	 * @param capacity How many elements to allocate memory for.
+	 */
+	void reserve(int capacity)
+	{
+		slots.reserve(capacity);
+		freeSlots.reserve(capacity);
+		denseToSlot.reserve(capacity);
+		std::apply([capacity](auto&... column) { (column.reserve(capacity), ...); }, columns);
+	}
+
+	/**
+	 * @brief Removes all elements. Handles to them become invalid.
+	 */
+	void clear()
+	{
+		while (size() > 0)
+			remove(handleAt(size() - 1));
+	}
+
+	/**
+	 * @brief Checks if an element exists.
+	 * @param handle The handle of the element.
+	 * @return Whether the element exists.
+	 */
+	bool contains(Handle handle) const
+	{
+		return denseIndex(handle) != -1;
+	}
+
+	/**
+	 * @brief Returns the position of an element in the dense arrays.
+	 * @param handle The handle of the element.
+	 * @return The position of the element, or -1 if it doesn't exist.
+	 */
+	int denseIndex(Handle handle) const
+	{
+		if (handle.index < 0 || handle.index >= (int)slots.size())
+			return -1;
+
+		const Slot& slot = slots[handle.index];
+		if (slot.generation != handle.generation)
+			return -1;
+		return slot.dense;
+	}
+
+	/**
+	 * @brief Returns the handle of the element in a position in the dense arrays.
+	 * @param dense The position.
+	 * @return The handle.
+	 */
+	Handle handleAt(int dense) const
+	{
+		int slot = denseToSlot[dense];
+		return { slot, slots[slot].generation };
+	}
+
+	/**
+	 * @brief Gets a value of an element.
+	 * @tparam I The column.
+	 * @param handle The handle of the element.
+	 * @return A pointer to the value, or nullptr if the element doesn't exist.
+	 */
+	template<int I> auto* get(Handle handle)
+	{
+		int dense = denseIndex(handle);
+		return dense == -1 ? nullptr : &std::get<I>(columns)[dense];
+	}
+
+	/**
+	 * @brief Returns a whole column, in the order of the dense arrays.
+	 * @tparam I The column.
+	 * @return The column.
+	 */
+	template<int I> auto& column()
+	{
+		return std::get<I>(columns);
+	}
+
+	/**
+	 * @brief Returns a whole column, in the order of the dense arrays.
+	 * @tparam I The column.
+	 * @return The column.
+	 */
+	template<int I> const auto& column() const
+	{
+		return std::get<I>(columns);
+	}
+
+	/**
+	 * @brief Returns the number of elements.
+	 * @return The number of elements.
+	 */
+	int size() const
+	{
+		return (int)denseToSlot.size();
+	}
+
+private:
+	struct Slot
+	{
+		int generation;
+		// position in the dense arrays, -1 if the slot is free
+		int dense;
+	};
+
+	/**
+	 * @brief Adds the values to the end of the dense arrays and points the slot to them.
+	 * @param slot The slot.
+	 * @param values The value of every column.
+	 */
+	void pushDense(int slot, Columns... values)
+	{
+		slots[slot].dense = size();
+		denseToSlot.push_back(slot);
+		pushColumns(std::index_sequence_for<Columns...>{}, std::move(values)...);
+	}
+
+	template<size_t... I> void pushColumns(std::index_sequence<I...>, Columns... values)
+	{
+		(std::get<I>(columns).push_back(std::move(values)), ...);
+	}
+
+	std::vector<Slot> slots;
+	std::vector<int> freeSlots;
+	std::vector<int> denseToSlot;
+	std::tuple<std::vector<Columns>...> columns;
+};
@@ -0,0 +1,192 @@
+#include "VisibilityMap.hpp"
+#include <cmath>
+#include "maze.hpp"
+#include "serialization.hpp"
+
+using namespace globals;
+
+static const int CELL_COUNT = WORLD_WIDTH * WORLD_HEIGHT;
+
+/**
+ * @brief Checks if any of the sample points in one cell can see any of the sample points in another.
+ * @param maze The maze.
+ * @param from The first cell.
+ * @param to The second cell.
+ * @return Whether a line of sight was found.
+ */
+static bool canSee(const MazeArr& maze, sf::Vector2i from, sf::Vector2i to)
+{
+	// the points are spread to near the edges of the cell, which a player can get close to
+	auto sample = [](sf::Vector2i cell, int i, int j)
+	{
+		float step = 0.98f / (VisibilityMap::SAMPLES - 1);
+		return sf::Vector2f(cell.x + 0.01f + i * step, cell.y + 0.01f + j * step);
+	};
+
+	for (int i = 0; i < VisibilityMap::SAMPLES * VisibilityMap::SAMPLES; i++)
+		for (int j = 0; j < VisibilityMap::SAMPLES * VisibilityMap::SAMPLES; j++)
+			if (hasLineOfSight(maze, sample(from, i % VisibilityMap::SAMPLES, i / VisibilityMap::SAMPLES), sample(to, j % VisibilityMap::SAMPLES, j / VisibilityMap::SAMPLES)))
+				return true;
+
+	return false;
+}
+
+VisibilityMap::VisibilityMap() : computed(false), maze{} {}
+
+/**
+ * @brief Finds the cells a straight line from a cell could reach: a line only moves towards its end one cell at a time,
+ * so it can only reach the cells that a path of empty cells that never turns back reaches (in one of the 4 quadrants).
+ * In a maze these are short stretches of corridors, so only they need their line of sight checked.
+ * @param maze The maze.
+ * @param from The cell, which must be empty.
+ * @param reached Set to whether every cell can be reached.
+ * @param candidates Set to the cells that can be reached, without from.
+ */
+static void findCandidates(const MazeArr& maze, sf::Vector2i from, std::vector<bool>& reached, std::vector<int>& candidates)
+{
+	std::fill(reached.begin(), reached.end(), false);
+	candidates.clear();
+
+	// reached only while walking the current quadrant, the cells on the axes are in two of them
+	std::vector<bool> walked(CELL_COUNT);
+	for (sf::Vector2i step : { sf::Vector2i(1, 1), sf::Vector2i(-1, 1), sf::Vector2i(1, -1), sf::Vector2i(-1, -1) })
+	{
+		std::fill(walked.begin(), walked.end(), false);
+		walked[from.y * WORLD_WIDTH + from.x] = true;
+
+		// a row that reaches nothing stops every row after it
+		bool rowReached = true;
+		for (int y = from.y; y >= 0 && y < WORLD_HEIGHT && rowReached; y += step.y)
+		{
+			rowReached = false;
+			for (int x = from.x; x >= 0 && x < WORLD_WIDTH; x += step.x)
+			{
+				int b = y * WORLD_WIDTH + x;
+				bool fromPrevious = (x != from.x && walked[b - step.x]) || (y != from.y && walked[b - step.y * WORLD_WIDTH]);
+				if (maze[y][x] == CELL_WALL || !(walked[b] || fromPrevious))
+				{
+					// the rest of the row can only be reached from the row before it
+					if (y == from.y)
+						break;
+					continue;
+				}
+
+				walked[b] = true;
+				rowReached = true;
+				if (!reached[b])
+				{
+					reached[b] = true;
+					if (b != from.y * WORLD_WIDTH + from.x)
+						candidates.push_back(b);
+				}
+			}
+		}
+	}
+}
+
+void VisibilityMap::compute(const MazeArr& maze)
+{
+	this->maze = maze;
+
+	serialization::Writer writer;
+	offsets.assign(CELL_COUNT, 0);
+	radii.assign(CELL_COUNT, 0);
+	std::vector<bool> visible(CELL_COUNT), reached(CELL_COUNT);
+	std::vector<int> candidates, seen;
+	for (int a = 0; a < CELL_COUNT; a++)
+	{
+		offsets[a] = (int)writer.getData().size();
+		sf::Vector2i cellA = { a % WORLD_WIDTH, a / WORLD_WIDTH };
+
+		// the cell itself, and the cells a line can reach that some sample points see
+		seen.clear();
+		if (maze[cellA.y][cellA.x] != CELL_WALL)
+		{
+			seen.push_back(a);
+			findCandidates(maze, cellA, reached, candidates);
+			for (int b : candidates)
+			{
+				// always from the lower index, so both sets agree even where a line and its reverse round differently
+				sf::Vector2i cellB = { b % WORLD_WIDTH, b / WORLD_WIDTH };
+				if (a < b ? canSee(maze, cellA, cellB) : canSee(maze, cellB, cellA))
+					seen.push_back(b);
+			}
+		}
+
+		// the cells around every seen cell, which also adds the walls that close the set
+		std::fill(visible.begin(), visible.end(), false);
+		for (int b : seen)
+		{
+			for (int y = b / WORLD_WIDTH - 1; y <= b / WORLD_WIDTH + 1; y++)
+				for (int x = b % WORLD_WIDTH - 1; x <= b % WORLD_WIDTH + 1; x++)
+					if (x >= 0 && x < WORLD_WIDTH && y >= 0 && y < WORLD_HEIGHT)
+						visible[y * WORLD_WIDTH + x] = true;
+		}
+
+		// the far corner of the farthest cell, from the farthest point in this cell
+		float radius = 0;
+		for (int b = 0; b < CELL_COUNT; b++)
+		{
+			if (!visible[b])
+				continue;
+			float dx = fabsf((float)(b % WORLD_WIDTH - cellA.x)) + 1, dy = fabsf((float)(b / WORLD_WIDTH - cellA.y)) + 1;
+			radius = fmaxf(radius, sqrtf(dx * dx + dy * dy));
+		}
+		radii[a] = radius;
+
+		// the runs, starting with hidden cells
+		bool value = false;
+		int length = 0;
+		for (int b = 0; b < CELL_COUNT; b++)
+		{
+			if (visible[b] != value)
+			{
+				writer.writeVarint(length);
+				value = !value;
+				length = 0;
+			}
+			length++;
+		}
+		writer.writeVarint(length);
+	}
+
+	runs = writer.getData();
+	computed = true;
+}
+
+void VisibilityMap::getVisible(sf::Vector2i cell, std::vector<bool>& visible) const
+{
+	int index = indexOf(cell);
+	visible.assign(CELL_COUNT, index < 0);
+	if (index < 0)
+		return;
+
+	serialization::Reader reader(runs.data() + offsets[index], (int)runs.size() - offsets[index]);
+	bool value = false;
+	for (int b = 0; b < CELL_COUNT; value = !value)
+	{
+		int length = (int)reader.readVarint();
+		if (reader.failed())
+			return;
+		for (int end = b + length < CELL_COUNT ? b + length : CELL_COUNT; b < end; b++)
+			visible[b] = value;
+	}
+}
+
+float VisibilityMap::getRadius(sf::Vector2i cell) const
+{
+	int index = indexOf(cell);
+	return index < 0 ? (float)WORLD_WIDTH : radii[index];
+}
+
+size_t VisibilityMap::getEncodedSize() const
+{
+	return runs.size();
+}
+
+int VisibilityMap::indexOf(sf::Vector2i cell) const
+{
+	if (!computed || cell.x < 0 || cell.x >= WORLD_WIDTH || cell.y < 0 || cell.y >= WORLD_HEIGHT || maze[cell.y][cell.x] == CELL_WALL)
+		return -1;
+	return cell.y * WORLD_WIDTH + cell.x;
+}
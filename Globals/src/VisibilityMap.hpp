@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "globals.hpp"
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief The potentially visible set (PVS) of every cell in a maze: the cells that can be seen from somewhere in it.
+ * It's computed once when the maze is known, by checking the line of sight between SAMPLES x SAMPLES points in the empty cells
+ * and the cells a straight line from them could reach, which in a maze are only short stretches of corridors.
+ * Every set is then grown by the cells around it, so a line that passes between the sample points isn't missed (it's conservative,
+ * a cell that isn't in the set can't be seen, but some cells in it may not be visible).
+ * The sets are kept run-length encoded, since in a maze they are mostly long runs of hidden cells,
+ * so a set is decoded once with getVisible and then looked up for every cell that needs checking.
+ * Cells are indexed by y * WORLD_WIDTH + x.
+ */
+class VisibilityMap
+{
+public:
+	// how many points on every axis of a cell are checked
+	inline static const int SAMPLES = 4;
+
+	/**
+	 * @brief Creates a new VisibilityMap object. Before compute is called, every cell is visible from everywhere.
+	 */
+	VisibilityMap();
+
+	/**
+	 * @brief Computes the sets of a maze.
+	 * @param maze The maze.
+	 */
+	void compute(const globals::MazeArr& maze);
+
+	/**
+	 * @brief Decodes the set of a cell.
+	 * @param cell The cell.
+	 * @param visible Set to whether every cell is in the set. Everything is visible from cells that are walls or outside the maze.
+	 */
+	void getVisible(sf::Vector2i cell, std::vector<bool>& visible) const;
+
+	/**
+	 * @brief Returns how far a ray from a cell can go before it hits a wall, for raycasting.
+	 * @param cell The cell.
+	 * @return The distance from any point in the cell to the far side of any wall in its set.
+	 */
+	float getRadius(sf::Vector2i cell) const;
+
+	/**
+	 * @brief Returns the size of the encoded sets.
+	 * @return The size in bytes.
+	 */
+	size_t getEncodedSize() const;
+
+private:
+	/**
+	 * @brief Returns the index of a cell.
+	 * @param cell The cell.
+	 * @return The index, or -1 if the cell is a wall, outside the maze or the sets weren't computed.
+	 */
+	int indexOf(sf::Vector2i cell) const;
+
+	bool computed;
+	globals::MazeArr maze;
+
+	// the run lengths of all the sets (hidden first, then alternating), as varints
+	std::vector<char> runs;
+	// where the set of every cell starts in runs
+	std::vector<int> offsets;
+	std::vector<float> radii;
+};
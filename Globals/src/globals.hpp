@@ -7,6 +7,8 @@ namespace globals
 {
 	inline const unsigned short TCP_PORT = 23456;
 	inline const unsigned short UDP_PORT = 23456;
+	// spectators connect here, with TCP and UDP, to a server or a relay
+	inline const unsigned short SPECTATOR_PORT = 23457;
 
 	inline const int MAX_LIFE = 3;
 
@@ -21,6 +23,16 @@ namespace globals
 	// how many seconds is the game
 	inline const int GAME_TIME = 180;
 
+	// how many times per second the server updates the game
+	inline const int SERVER_TICKS = 60;
+
+	// the most ticks a hit can be checked in the past (half a second): the shooter's interpolation delay plus
+	// their round trip time, which clients keep below this
+	inline const int MAX_REWIND_TICKS = 30;
+
+	// positions are simulated and sent with a precision of 1 / POSITION_SCALE
+	inline const float POSITION_SCALE = 256.0f;
+
 	// cell state
 	enum
 	{
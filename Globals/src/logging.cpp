@@ -0,0 +1,249 @@
+#include "logging.hpp"
+#include "MpscQueue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <unordered_map>
+
+namespace logging
+{
+	struct Entry
+	{
+		Level level = Level::INFO;
+		// milliseconds since the epoch
+		int64_t time = 0;
+		std::string message;
+		std::vector<Field> fields;
+	};
+
+	// how many times a message was logged in the last second it was logged in
+	struct RateCount
+	{
+		int64_t second = 0;
+		int count = 0;
+	};
+
+	// the counts of messages that weren't logged this second are forgotten when there are more different messages than this
+	static const size_t MAX_RATE_MESSAGES = 1024;
+
+	static MpscQueue<Entry> queue(QUEUE_CAPACITY);
+	// every message text has its own count, so a flood of one message doesn't suppress another
+	static std::unordered_map<std::string, RateCount> rateCounts;
+	static std::mutex rateMutex;
+	static std::atomic<Level> minimum = Level::INFO;
+	static std::atomic<bool> running = false;
+	static std::atomic<int> dropped = 0;
+	// released for every pushed message (and once to stop), the writer sleeps on it
+	static std::counting_semaphore<> pending(0);
+	// how many log calls are between checking running and pushing, stop waits for them before the last drain
+	static std::atomic<int> pushing = 0;
+	static std::thread writer;
+	static std::ofstream jsonFile;
+	// the writer thread writes alone while it runs, but messages logged while it stops are written directly
+	static std::mutex outputMutex;
+
+	/**
+	 * @brief Returns the name of a level.
+	 * @param level The level.
+	 * @return The name.
+	 */
+	static const char* levelName(Level level)
+	{
+		switch (level)
+		{
+		case Level::DEBUG: return "debug";
+		case Level::INFO: return "info";
+		case Level::WARNING: return "warning";
+		default: return "error";
+		}
+	}
+
+	/**
+	 * @brief Escapes a string to be put in JSON quotes.
+	 * @param str The string.
+	 * @return The escaped string.
+	 */
+	static std::string escapeJson(const std::string& str)
+	{
+		std::string escaped;
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				escaped += '\\';
+				escaped += c;
+			}
+			else if (c == '\n')
+				escaped += "\\n";
+			else if ((unsigned char)c < 0x20)
+			{
+				char hex[7];
+				snprintf(hex, sizeof(hex), "\\u%04x", c);
+				escaped += hex;
+			}
+			else
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	/**
+	 * @brief Writes a message to the console and the JSON file. outputMutex must be locked.
+	 * @param entry The message.
+	 */
+	static void write(const Entry& entry)
+	{
+		std::string text = std::string("[") + levelName(entry.level) + "] " + entry.message;
+		for (const Field& field : entry.fields)
+			text += " " + field.key + "=" + field.value;
+		std::cout << text << '\n';
+
+		if (jsonFile.is_open())
+		{
+			std::string json = "{\"time\":" + std::to_string(entry.time) + ",\"level\":\"" + levelName(entry.level) + "\",\"message\":\"" + escapeJson(entry.message) + "\"";
+			for (const Field& field : entry.fields)
+				json += ",\"" + escapeJson(field.key) + "\":\"" + escapeJson(field.value) + "\"";
+			jsonFile << json << "}\n";
+		}
+	}
+
+	/**
+	 * @brief Writes every message in the queue, then reports dropped messages and flushes.
+	 */
+	static void drain()
+	{
+		std::lock_guard lock(outputMutex);
+
+		while (std::optional<Entry> entry = queue.pop())
+			write(*entry);
+
+		int droppedCount = dropped.exchange(0);
+		if (droppedCount > 0)
+			write({ Level::WARNING, 0, "Log queue is full, messages were dropped", { { "dropped", std::to_string(droppedCount) } } });
+
+		// flushing only when there is nothing left to write
+		std::cout.flush();
+		if (jsonFile.is_open())
+			jsonFile.flush();
+	}
+
+	/**
+	 * @brief Writes messages as they are pushed until the logger stops.
+	 */
+	static void writeLoop()
+	{
+		while (true)
+		{
+			pending.acquire();
+			drain();
+
+			if (!running)
+				break;
+		}
+	}
+
+	/**
+	 * @brief Counts a message against the rate limit.
+	 * @param message The message.
+	 * @param now The current time in milliseconds.
+	 * @param suppressed Set to how many times the message was suppressed in the last second it was logged.
+	 * @return Whether the message should be logged.
+	 */
+	static bool checkRateLimit(const std::string& message, int64_t now, int& suppressed)
+	{
+		std::lock_guard lock(rateMutex);
+
+		int64_t second = now / 1000;
+		auto found = rateCounts.find(message);
+		if (found == rateCounts.end())
+		{
+			if (rateCounts.size() >= MAX_RATE_MESSAGES)
+				std::erase_if(rateCounts, [second](const auto& item) { return item.second.second != second; });
+			found = rateCounts.emplace(message, RateCount{ second, 0 }).first;
+		}
+
+		RateCount& count = found->second;
+		if (count.second != second)
+		{
+			// first message of a new second
+			suppressed = std::max(count.count - RATE_LIMIT, 0);
+			count = { second, 1 };
+			return true;
+		}
+
+		suppressed = 0;
+		return count.count++ < RATE_LIMIT;
+	}
+
+	void start(Level minimumLevel, const std::string& jsonPath)
+	{
+		if (running)
+			return;
+
+		minimum = minimumLevel;
+		if (jsonPath != "")
+		{
+			jsonFile.open(jsonPath, std::ios::app);
+			if (!jsonFile.is_open())
+				std::cout << "Couldn't open log file '" << jsonPath << "'." << std::endl;
+		}
+
+		running = true;
+		writer = std::thread(writeLoop);
+	}
+
+	void stop()
+	{
+		if (!running)
+			return;
+
+		running = false;
+		pending.release();
+		writer.join();
+
+		// messages pushed while the writer was stopping are still in the queue
+		while (pushing > 0)
+			std::this_thread::yield();
+		drain();
+
+		std::lock_guard lock(outputMutex);
+		jsonFile.close();
+	}
+
+	void log(Level level, const std::string& message, std::vector<Field> fields)
+	{
+		if (level < minimum.load(std::memory_order_relaxed))
+			return;
+
+		int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		int suppressed = 0;
+		if (!checkRateLimit(message, now, suppressed))
+			return;
+		if (suppressed > 0)
+			fields.push_back({ "suppressed", std::to_string(suppressed) });
+
+		Entry entry = { level, now, message, std::move(fields) };
+
+		pushing++;
+		if (!running)
+		{
+			pushing--;
+			std::lock_guard lock(outputMutex);
+			write(entry);
+			return;
+		}
+
+		if (queue.push(std::move(entry)))
+			pending.release();
+		else
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		pushing--;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * Asynchronous structured logging.
+ * Messages are pushed to a lock-free queue and written by a background thread,
+ * so logging never blocks on I/O. Every message is written to the console, and to a JSON lines file if one is set.
+ */
+namespace logging
+{
+	enum class Level : char
+	{
+		DEBUG,
+		INFO,
+		WARNING,
+		// ERROR is a macro in the Windows headers
+		ERR
+	};
+
+	/**
+	 * @brief A named value attached to a message.
+	 */
+	struct Field
+	{
+		std::string key;
+		std::string value;
+	};
+
+	// how many messages can wait for the writer before new ones are dropped
+	inline const int QUEUE_CAPACITY = 4096;
+
+	// how many times the same message can be logged every second
+	inline const int RATE_LIMIT = 5;
+
+	/**
+	 * @brief Starts the writer thread. Until it is started, messages are written directly to the console.
+	 * @param minimumLevel Messages below this level are ignored.
+	 * @param jsonPath A file to also write the messages to as JSON lines, or an empty string for only the console.
+	 */
+	void start(Level minimumLevel = Level::INFO, const std::string& jsonPath = "");
+
+	/**
+	 * @brief Writes all the waiting messages and stops the writer thread.
+	 */
+	void stop();
+
+	/**
+	 * @brief Logs a message. Can be called from any thread.
+	 * A message that is repeated more than RATE_LIMIT times in a second is suppressed,
+	 * and the next one that gets through says how many were suppressed.
+	 * @param level The level of the message.
+	 * @param message The message.
+	 * @param fields Values attached to the message.
+	 */
+	void log(Level level, const std::string& message, std::vector<Field> fields = {});
+
+	/**
+	 * @brief Logs a debug message.
+	 * @param message The message.
+	 * @param fields Values attached to the message.
+	 */
+	inline void debug(const std::string& message, std::vector<Field> fields = {})
+	{
+		log(Level::DEBUG, message, std::move(fields));
+	}
+
+	/**
+	 * @brief Logs an info message.
+	 * @param message The message.
+	 * @param fields Values attached to the message.
+	 */
+	inline void info(const std::string& message, std::vector<Field> fields = {})
+	{
+		log(Level::INFO, message, std::move(fields));
+	}
+
+	/**
+	 * @brief Logs a warning message.
+	 * @param message The message.
+	 * @param fields Values attached to the message.
+	 */
+	inline void warning(const std::string& message, std::vector<Field> fields = {})
+	{
+		log(Level::WARNING, message, std::move(fields));
+	}
+
+	/**
+	 * @brief Logs an error message.
+	 * @param message The message.
+	 * @param fields Values attached to the message.
+	 */
+	inline void error(const std::string& message, std::vector<Field> fields = {})
+	{
+		log(Level::ERR, message, std::move(fields));
+	}
+}
@@ -2,6 +2,7 @@
 #include "util.hpp"
 #include <stack>
 #include <vector>
+#include <cmath>
 
 struct Cell
 {
@@ -123,4 +124,44 @@ namespace globals
 		return maze;
 	}
 #endif
+
+	bool hasLineOfSight(const MazeArr& maze, sf::Vector2f from, sf::Vector2f to)
+	{
+		sf::Vector2f delta = to - from;
+		sf::Vector2i cell = { (int)from.x, (int)from.y };
+		sf::Vector2i target = { (int)to.x, (int)to.y };
+		sf::Vector2i step = { delta.x < 0 ? -1 : 1, delta.y < 0 ? -1 : 1 };
+
+		// how much of the line it takes to cross a whole cell on every axis
+		float lineStepX = delta.x != 0 ? fabsf(1 / delta.x) : INFINITY;
+		float lineStepY = delta.y != 0 ? fabsf(1 / delta.y) : INFINITY;
+
+		// how much of the line it takes to reach the next cell on every axis
+		float lineToNextX = (step.x > 0 ? cell.x + 1 - from.x : from.x - cell.x) * lineStepX;
+		float lineToNextY = (step.y > 0 ? cell.y + 1 - from.y : from.y - cell.y) * lineStepY;
+
+		// every step moves one cell on one axis
+		int steps = abs(target.x - cell.x) + abs(target.y - cell.y);
+
+		for (int i = 0; i < steps; i++)
+		{
+			if (lineToNextX < lineToNextY)
+			{
+				cell.x += step.x;
+				lineToNextX += lineStepX;
+			}
+			else
+			{
+				cell.y += step.y;
+				lineToNextY += lineStepY;
+			}
+
+			if (cell.x < 0 || cell.x >= WORLD_WIDTH || cell.y < 0 || cell.y >= WORLD_HEIGHT)
+				return false;
+			if (maze[cell.y][cell.x] == CELL_WALL)
+				return false;
+		}
+
+		return true;
+	}
 }
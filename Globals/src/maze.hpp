@@ -1,6 +1,7 @@
 #pragma once
 
 #include "globals.hpp"
+#include "SFML/System/Vector2.hpp"
 
 namespace globals
 {
@@ -9,4 +10,13 @@ namespace globals
 	 * @return A random maze.
 	 */
 	MazeArr generateMaze();
+
+	/**
+	 * @brief Checks if there are no walls between two points, by walking over the cells between them (DDA).
+	 * @param maze The maze.
+	 * @param from The first point.
+	 * @param to The second point.
+	 * @return Whether there's a line of sight between the points.
+	 */
+	bool hasLineOfSight(const MazeArr& maze, sf::Vector2f from, sf::Vector2f to);
 }
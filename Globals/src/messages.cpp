@@ -0,0 +1,189 @@
+#include "messages.hpp"
+#include <thread>
+#include "protocol.hpp"
+#include "logging.hpp"
+
+namespace messages
+{
+	// the size before every message on TCP, little-endian
+	static const int HEADER_SIZE = 2;
+
+	// the biggest message that fits the header
+	static const int MAX_MESSAGE_SIZE = 0xFFFF;
+
+	FieldWriter::FieldWriter(serialization::Writer& writer) : writer(writer) {}
+
+	void FieldWriter::operator()(int value)
+	{
+		writer.writeSignedVarint(value);
+	}
+
+	void FieldWriter::operator()(bool value)
+	{
+		writer.writeByte(value);
+	}
+
+	void FieldWriter::operator()(const std::string& value)
+	{
+		writer.writeString(value);
+	}
+
+	void FieldWriter::operator()(sf::Vector2f value)
+	{
+		writer.writeFixed(value.x, globals::POSITION_SCALE);
+		writer.writeFixed(value.y, globals::POSITION_SCALE);
+	}
+
+	void FieldWriter::operator()(const globals::MazeArr& value)
+	{
+		for (const auto& row : value)
+			writer.writeBytes(std::vector<char>(row.begin(), row.end()));
+	}
+
+	FieldReader::FieldReader(serialization::Reader& reader) : reader(reader) {}
+
+	void FieldReader::operator()(int& value)
+	{
+		value = reader.readSignedVarint();
+	}
+
+	void FieldReader::operator()(bool& value)
+	{
+		value = reader.readByte() != 0;
+	}
+
+	void FieldReader::operator()(std::string& value)
+	{
+		value = reader.readString();
+	}
+
+	void FieldReader::operator()(sf::Vector2f& value)
+	{
+		value.x = reader.readFixed(globals::POSITION_SCALE);
+		value.y = reader.readFixed(globals::POSITION_SCALE);
+	}
+
+	void FieldReader::operator()(globals::MazeArr& value)
+	{
+		for (auto& row : value)
+		{
+			std::vector<char> bytes = reader.readBytes((int)row.size());
+			if (reader.failed())
+				return;
+			std::copy(bytes.begin(), bytes.end(), row.begin());
+		}
+	}
+
+	void sendEncoded(const sockets::Socket& tcpSocket, const std::vector<char>& data)
+	{
+		if ((int)data.size() > MAX_MESSAGE_SIZE)
+		{
+			logging::error("Message too big", { { "size", std::to_string(data.size()) } });
+			return;
+		}
+
+		std::vector<char> frame = { (char)(data.size() & 0xFF), (char)(data.size() >> 8) };
+		frame.insert(frame.end(), data.begin(), data.end());
+
+		// send can take only part of the frame
+		int sent = 0;
+		while (sent < (int)frame.size())
+			sent += tcpSocket.send(frame.data() + sent, (int)frame.size() - sent);
+	}
+
+	/**
+	 * @brief Receives exactly size bytes. Once a byte arrived, waits for the rest even on a non-blocking socket.
+	 * @param tcpSocket The socket.
+	 * @param buffer Set to the bytes.
+	 * @param size How many bytes to receive.
+	 * @param started Whether part of the message already arrived.
+	 * @return Whether all the bytes arrived, false if none arrived yet (and the message didn't start) or the connection closed.
+	 */
+	static bool receiveAll(const sockets::Socket& tcpSocket, std::vector<char>& buffer, int size, bool started)
+	{
+		buffer.clear();
+		while ((int)buffer.size() < size)
+		{
+			try
+			{
+				std::vector<char> data = tcpSocket.recv(size - (int)buffer.size());
+				// the connection closed
+				if (data.empty())
+					return false;
+				buffer.insert(buffer.end(), data.begin(), data.end());
+			}
+			catch (sockets::exception& err)
+			{
+				if (err.getErrorCode() != WSAEWOULDBLOCK)
+					throw;
+				if (!started && buffer.empty())
+					return false;
+				std::this_thread::yield();
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<char> receive(const sockets::Socket& tcpSocket)
+	{
+		try
+		{
+			std::vector<char> header;
+			if (!receiveAll(tcpSocket, header, HEADER_SIZE, false))
+				return {};
+
+			int size = (uint8_t)header[0] | ((uint8_t)header[1] << 8);
+			std::vector<char> data;
+			if (!receiveAll(tcpSocket, data, size, true))
+				return {};
+
+			return data;
+		}
+		catch (sockets::exception& err)
+		{
+			logging::error("Error receiving message", { { "error", err.what() } });
+			return {};
+		}
+	}
+
+	bool receiveAvailable(const sockets::Socket& tcpSocket, std::vector<char>& buffer, std::vector<std::vector<char>>& received)
+	{
+		bool open = true;
+
+		while (true)
+		{
+			try
+			{
+				std::vector<char> data = tcpSocket.recv(4096);
+				if (data.empty())
+				{
+					open = false;
+					break;
+				}
+				buffer.insert(buffer.end(), data.begin(), data.end());
+			}
+			catch (sockets::exception& err)
+			{
+				if (err.getErrorCode() != WSAEWOULDBLOCK)
+					throw;
+				break;
+			}
+		}
+
+		// every whole frame: the size, then the message
+		int offset = 0;
+		while ((int)buffer.size() - offset >= HEADER_SIZE)
+		{
+			int size = (uint8_t)buffer[offset] | ((uint8_t)buffer[offset + 1] << 8);
+			if ((int)buffer.size() - offset - HEADER_SIZE < size)
+				break;
+
+			received.emplace_back(buffer.begin() + offset + HEADER_SIZE, buffer.begin() + offset + HEADER_SIZE + size);
+			offset += HEADER_SIZE + size;
+		}
+		buffer.erase(buffer.begin(), buffer.begin() + offset);
+
+		return open;
+	}
+}
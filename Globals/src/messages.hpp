@@ -0,0 +1,306 @@
+#pragma once
+#include <array>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "sockets.hpp"
+#include "serialization.hpp"
+#include "globals.hpp"
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief The messages of the lobby (TCP) and the gameplay events (on the reliable channel).
+ * Every message is a struct that lists its fields once in fields(), which both encodes and decodes it.
+ * An encoded message is its ID (its position in Registry) followed by its fields.
+ */
+namespace messages
+{
+	// lobby messages
+
+	// client -> server: the player's name, server -> clients: a player joined
+	struct Player
+	{
+		std::string name;
+		template<typename F> void fields(F& f) { f(name); }
+	};
+
+	// client -> server: the client's UDP port
+	struct Udp
+	{
+		int port = 0;
+		template<typename F> void fields(F& f) { f(port); }
+	};
+
+	// server -> client: the client's index in the game
+	struct Index
+	{
+		int index = 0;
+		template<typename F> void fields(F& f) { f(index); }
+	};
+
+	// server -> clients: all the players joined and the game starts soon
+	struct Soon
+	{
+		template<typename F> void fields(F& f) {}
+	};
+
+	// server -> clients: the game started
+	struct Start
+	{
+		globals::MazeArr maze = {};
+		template<typename F> void fields(F& f) { f(maze); }
+	};
+
+	// client -> server: the client left
+	struct Close
+	{
+		template<typename F> void fields(F& f) {}
+	};
+
+	// spectator -> server: the token the server logged, before Udp (relays don't need one)
+	struct Watch
+	{
+		std::string token;
+		template<typename F> void fields(F& f) { f(token); }
+	};
+
+	// gameplay events
+
+	// the player got hit
+	struct Hit
+	{
+		template<typename F> void fields(F& f) {}
+	};
+
+	// the player eliminated someone
+	struct Score
+	{
+		int points = 0;
+		template<typename F> void fields(F& f) { f(points); }
+	};
+
+	// a player spawned or respawned
+	struct Init
+	{
+		int index = 0;
+		sf::Vector2f position;
+		template<typename F> void fields(F& f) { f(index); f(position); }
+	};
+
+	// a player left
+	struct Exit
+	{
+		int index = 0;
+		template<typename F> void fields(F& f) { f(index); }
+	};
+
+	// how many seconds are left in the game
+	struct Timer
+	{
+		int seconds = 0;
+		template<typename F> void fields(F& f) { f(seconds); }
+	};
+
+	// the game ended
+	struct End
+	{
+		// who won
+		std::string winners;
+		template<typename F> void fields(F& f) { f(winners); }
+	};
+
+	// LAN discovery
+
+	// server -> anyone that sent a DISCOVER packet: the server's status, in a SERVER_INFO packet
+	struct ServerInfo
+	{
+		std::string name;
+		int players = 0;
+		int maxPlayers = 0;
+		int mazeWidth = 0;
+		int mazeHeight = 0;
+		// whether the game started (players can't join, spectators can)
+		bool started = false;
+		template<typename F> void fields(F& f) { f(name); f(players); f(maxPlayers); f(mazeWidth); f(mazeHeight); f(started); }
+	};
+
+	// every message, a message's ID is its position here (new messages go at the end)
+	using Registry = std::tuple<Player, Udp, Index, Soon, Start, Close, Hit, Score, Init, Exit, Timer, End, ServerInfo, Watch>;
+
+	inline constexpr size_t COUNT = std::tuple_size_v<Registry>;
+
+	/**
+	 * @brief Finds the ID of a message type at compile time.
+	 * @tparam M The message type.
+	 * @return The ID.
+	 */
+	template<typename M, size_t I = 0> constexpr uint8_t idOf()
+	{
+		static_assert(I < COUNT, "The message isn't in the registry");
+		if constexpr (std::is_same_v<M, std::tuple_element_t<I, Registry>>)
+			return (uint8_t)I;
+		else
+			return idOf<M, I + 1>();
+	}
+
+	template<typename M> inline constexpr uint8_t ID = idOf<M>();
+
+	/**
+	 * @brief Writes the fields of a message.
+	 */
+	class FieldWriter
+	{
+	public:
+		FieldWriter(serialization::Writer& writer);
+
+		void operator()(int value);
+		void operator()(bool value);
+		void operator()(const std::string& value);
+		void operator()(sf::Vector2f value);
+		void operator()(const globals::MazeArr& value);
+
+	private:
+		serialization::Writer& writer;
+	};
+
+	/**
+	 * @brief Reads the fields of a message.
+	 */
+	class FieldReader
+	{
+	public:
+		FieldReader(serialization::Reader& reader);
+
+		void operator()(int& value);
+		void operator()(bool& value);
+		void operator()(std::string& value);
+		void operator()(sf::Vector2f& value);
+		void operator()(globals::MazeArr& value);
+
+	private:
+		serialization::Reader& reader;
+	};
+
+	/**
+	 * @brief Encodes a message.
+	 * @tparam M The message type.
+	 * @param message The message.
+	 * @return The ID and the fields.
+	 */
+	template<typename M> std::vector<char> encode(const M& message)
+	{
+		serialization::Writer writer;
+		writer.writeByte(ID<M>);
+
+		// fields() is shared with decoding, the writer only reads the fields
+		FieldWriter fieldWriter(writer);
+		const_cast<M&>(message).fields(fieldWriter);
+
+		return writer.getData();
+	}
+
+	/**
+	 * @brief Sends an encoded message with its size before it (TCP).
+	 * @param tcpSocket The socket.
+	 * @param data The encoded message.
+	 */
+	void sendEncoded(const sockets::Socket& tcpSocket, const std::vector<char>& data);
+
+	/**
+	 * @brief Encodes a message and sends it with its size before it (TCP).
+	 * @tparam M The message type.
+	 * @param tcpSocket The socket.
+	 * @param message The message.
+	 */
+	template<typename M> void send(const sockets::Socket& tcpSocket, const M& message)
+	{
+		sendEncoded(tcpSocket, encode(message));
+	}
+
+	/**
+	 * @brief Receives a message that was sent with send (TCP).
+	 * On a non-blocking socket, returns nothing if no message started arriving, and waits for the rest of a message that did.
+	 * @param tcpSocket The socket.
+	 * @return The encoded message, or an empty vector if there was none or the connection closed or failed.
+	 */
+	std::vector<char> receive(const sockets::Socket& tcpSocket);
+
+	/**
+	 * @brief Receives whatever arrived on a non-blocking socket without waiting, and takes out the messages that arrived whole.
+	 * The start of a message that didn't arrive whole stays in the buffer for the next call.
+	 * @param tcpSocket The socket, non-blocking.
+	 * @param buffer The bytes received so far, kept between calls.
+	 * @param received The messages that arrived whole are added to it.
+	 * @return Whether the connection is still open.
+	 */
+	bool receiveAvailable(const sockets::Socket& tcpSocket, std::vector<char>& buffer, std::vector<std::vector<char>>& received);
+
+	/**
+	 * @brief Checks the type of an encoded message without decoding it.
+	 * @tparam M The message type.
+	 * @param data The encoded message.
+	 * @return Whether the message is of type M.
+	 */
+	template<typename M> bool is(const std::vector<char>& data)
+	{
+		return !data.empty() && (uint8_t)data[0] == ID<M>;
+	}
+
+	/**
+	 * @brief Decodes a message of a known type and passes it to a handler, if the handler takes it.
+	 * @return Whether the message was valid.
+	 */
+	template<typename M, typename Handler> bool decodeAndHandle(serialization::Reader& reader, Handler& handler)
+	{
+		M message;
+		FieldReader fieldReader(reader);
+		message.fields(fieldReader);
+
+		if (reader.failed() || !reader.atEnd())
+			return false;
+
+		if constexpr (std::is_invocable_v<Handler&, const M&>)
+			handler(message);
+		return true;
+	}
+
+	/**
+	 * @brief Makes a table of the decode function of every message for a handler, by ID.
+	 */
+	template<typename Handler, size_t... I> constexpr auto makeDispatchTable(std::index_sequence<I...>)
+	{
+		using Decode = bool (*)(serialization::Reader&, Handler&);
+		return std::array<Decode, sizeof...(I)>{ &decodeAndHandle<std::tuple_element_t<I, Registry>, Handler>... };
+	}
+
+	/**
+	 * @brief Decodes a message and calls the handler's overload for its type, with one jump through a table by the ID.
+	 * Messages the handler has no overload for are ignored.
+	 * @param data The encoded message.
+	 * @param handler Called with the decoded message, usually a Handlers of lambdas.
+	 * @return Whether the message was valid.
+	 */
+	template<typename Handler> bool dispatch(const std::vector<char>& data, Handler&& handler)
+	{
+		using HandlerType = std::remove_reference_t<Handler>;
+		static constexpr auto table = makeDispatchTable<HandlerType>(std::make_index_sequence<COUNT>());
+
+		serialization::Reader reader(data.data(), (int)data.size());
+		uint8_t id = reader.readByte();
+		if (reader.failed() || id >= COUNT)
+			return false;
+
+		return table[id](reader, handler);
+	}
+
+	/**
+	 * @brief Combines lambdas into one handler with an overload for every message type they take.
+	 */
+	template<typename... Fs> struct Handlers : Fs...
+	{
+		using Fs::operator()...;
+	};
+	template<typename... Fs> Handlers(Fs...) -> Handlers<Fs...>;
+}
@@ -1,63 +1,217 @@
 #include "protocol.hpp"
-#include <iostream>
+#include "serialization.hpp"
+#include "globals.hpp"
+#include "logging.hpp"
 
 namespace protocol
 {
-	std::pair<std::string, std::string> receiveKeyValue(const sockets::Socket& tcpSocket)
+	// flags for which fields are in an encoded packet
+	enum : unsigned char
 	{
-		std::string key = "", value = "";
-		char data = 0;
-		bool toKey = true;
+		HAS_POSITION = 1 << 0,
+		HAS_DIRECTION = 1 << 1,
+		HAS_SEQUENCE = 1 << 2,
+		HAS_INPUT = 1 << 3,
+		HAS_TICK = 1 << 4
+	};
 
-		while (data != KEY_VALUE_END)
+	// the type is in the low 3 bits of the header, the flags are above it
+	static const int TYPE_BITS = 3;
+
+	/**
+	 * @brief Returns which fields a type of packet uses.
+	 * @param type The type of the packet.
+	 * @return The flags of the fields.
+	 */
+	static unsigned char fieldsOf(PacketType type)
+	{
+		switch (type)
 		{
-			try
-			{
-				data = tcpSocket.recv(1)[0];
+		case PacketType::UPDATE_PLAYER:
+			return HAS_POSITION | HAS_DIRECTION | HAS_SEQUENCE | HAS_TICK;
+		case PacketType::UPDATE_BULLET:
+			return HAS_POSITION | HAS_DIRECTION | HAS_TICK;
+		case PacketType::CLEAR_BULLETS:
+			return HAS_TICK;
+		case PacketType::PLAYER_INPUT:
+			return HAS_DIRECTION | HAS_SEQUENCE | HAS_INPUT;
+		case PacketType::RELIABLE:
+			return HAS_TICK;
+		case PacketType::DISCOVER:
+		case PacketType::SERVER_INFO:
+			// the sequence is the timestamp of the probe, echoed in the answer
+			return HAS_SEQUENCE;
+		default:
+			return 0;
+		}
+	}
 
-				if (data == KEY_VALUE_SEPERATOR)
-					toKey = false;
-				else if (data != KEY_VALUE_END)
-				{
-					if (toKey)
-						key += data;
-					else
-						value += data;
-				}
-			}
-			catch (sockets::exception& err)
-			{
-				if (err.getErrorCode() != WSAEWOULDBLOCK)
-					std::cout << "Error in key/value: " << err.what() << std::endl;
-				return std::make_pair("", "");
-			}
+	/**
+	 * @brief Checks if a type of packet has a payload.
+	 * @param type The type of the packet.
+	 * @return Whether the rest of the packet is its payload.
+	 */
+	static bool hasPayload(PacketType type)
+	{
+		return type == PacketType::RELIABLE || type == PacketType::SERVER_INFO || type == PacketType::DISCOVER;
+	}
+
+	/**
+	 * @brief Packs WASD input (every axis is -1, 0 or 1) in 4 bits.
+	 * @param input The input.
+	 * @return The packed input.
+	 */
+	static unsigned char packInput(sf::Vector2f input)
+	{
+		auto axis = [](float value) { return (unsigned char)((value > 0) | ((value < 0) << 1)); };
+		return axis(input.x) | (axis(input.y) << 2);
+	}
+
+	/**
+	 * @brief Unpacks WASD input.
+	 * @param packed The packed input.
+	 * @return The input.
+	 */
+	static sf::Vector2f unpackInput(unsigned char packed)
+	{
+		auto axis = [](unsigned char bits) { return (float)((bits & 1) - ((bits >> 1) & 1)); };
+		return { axis(packed & 3), axis((packed >> 2) & 3) };
+	}
+
+	std::vector<char> encodePacket(const Packet& packet)
+	{
+		serialization::Writer writer;
+		unsigned char fields = fieldsOf(packet.type);
+
+		writer.writeByte(PROTOCOL_VERSION);
+		writer.writeByte((unsigned char)packet.type | (fields << TYPE_BITS));
+		writer.writeSignedVarint(packet.index);
+
+		if (fields & HAS_TICK)
+			writer.writeVarint(packet.tick);
+		if (fields & HAS_SEQUENCE)
+			writer.writeVarint(packet.sequence);
+		if (fields & HAS_POSITION)
+		{
+			writer.writeFixed(packet.position.x, globals::POSITION_SCALE);
+			writer.writeFixed(packet.position.y, globals::POSITION_SCALE);
 		}
+		if (fields & HAS_DIRECTION)
+			writer.writeAngle(packet.direction);
+		if (fields & HAS_INPUT)
+			writer.writeByte(packInput(packet.input));
 
-		return std::make_pair(key, value);
+		// the payload takes the rest of the packet
+		if (hasPayload(packet.type))
+			writer.writeBytes(packet.payload);
+
+		return writer.getData();
 	}
 
-	std::string keyValueMessage(std::string key, std::string value)
+	bool decodePacket(const char* data, int size, Packet& packet)
 	{
-		return key + KEY_VALUE_SEPERATOR + value + KEY_VALUE_END;
+		serialization::Reader reader(data, size);
+
+		if (reader.readByte() != PROTOCOL_VERSION)
+			return false;
+
+		unsigned char header = reader.readByte();
+		unsigned char fields = header >> TYPE_BITS;
+
+		packet = Packet();
+		packet.type = (PacketType)(header & ((1 << TYPE_BITS) - 1));
+		if (packet.type == PacketType::NO_PACKET || packet.type > PacketType::SERVER_INFO || fields != fieldsOf(packet.type))
+			return false;
+
+		packet.index = reader.readSignedVarint();
+
+		if (fields & HAS_TICK)
+			packet.tick = reader.readVarint();
+		if (fields & HAS_SEQUENCE)
+			packet.sequence = reader.readVarint();
+		if (fields & HAS_POSITION)
+		{
+			packet.position.x = reader.readFixed(globals::POSITION_SCALE);
+			packet.position.y = reader.readFixed(globals::POSITION_SCALE);
+		}
+		if (fields & HAS_DIRECTION)
+			packet.direction = reader.readAngle();
+		if (fields & HAS_INPUT)
+			packet.input = unpackInput(reader.readByte());
+		if (hasPayload(packet.type))
+			packet.payload = reader.readBytes(reader.remaining());
+
+		return !reader.failed() && reader.atEnd();
 	}
 
-	Packet receivePacket(const sockets::Socket& udpSocket)
+	Packet quantize(const Packet& packet)
+	{
+		std::vector<char> data = encodePacket(packet);
+
+		Packet quantized;
+		decodePacket(data.data(), (int)data.size(), quantized);
+		quantized.address = packet.address;
+
+		return quantized;
+	}
+
+	Packet receivePacket(const sockets::Transport& transport)
 	{
+		Packet packet;
+
 		try
 		{
-			auto [packet, address] = udpSocket.recvFrom<Packet>();
-			return packet;
+			// skip invalid packets until a valid one arrives
+			while (true)
+			{
+				try
+				{
+					auto [data, address] = transport.recvFrom(MAX_PACKET_SIZE);
+					traffic.packetsReceived.fetch_add(1, std::memory_order_relaxed);
+					traffic.bytesReceived.fetch_add(data.size(), std::memory_order_relaxed);
+					if (decodePacket(data.data(), data.size(), packet))
+					{
+						packet.address = address;
+						return packet;
+					}
+				}
+				catch (sockets::exception& err)
+				{
+					// too big to be a packet
+					if (err.getErrorCode() != WSAEMSGSIZE)
+						throw;
+				}
+			}
 		}
 		catch (sockets::exception& err)
 		{
-			if (err.getErrorCode() != WSAEWOULDBLOCK)
-				std::cout << "Error: " << err.what() << std::endl;
+			// a blocking socket with a timeout times out instead
+			if (err.getErrorCode() != WSAEWOULDBLOCK && err.getErrorCode() != WSAETIMEDOUT)
+				logging::error("Error receiving packet", { { "error", err.what() } });
 			return { PacketType::NO_PACKET, 0, { 0, 0 } };
 		}
 	}
 
-	void sendPacket(const sockets::Socket& udpSocket, const sockets::Address& address, Packet packet)
+	Packet receivePacket(const sockets::Socket& udpSocket)
+	{
+		return receivePacket(sockets::UdpTransport(udpSocket));
+	}
+
+	int sendPacket(const sockets::Transport& transport, const sockets::Address& address, Packet packet)
+	{
+		return sendEncoded(transport, address, encodePacket(packet));
+	}
+
+	int sendEncoded(const sockets::Transport& transport, const sockets::Address& address, const std::vector<char>& data)
+	{
+		int sent = transport.sendTo(data, address);
+		traffic.packetsSent.fetch_add(1, std::memory_order_relaxed);
+		traffic.bytesSent.fetch_add(sent, std::memory_order_relaxed);
+		return sent;
+	}
+
+	int sendPacket(const sockets::Socket& udpSocket, const sockets::Address& address, Packet packet)
 	{
-		udpSocket.sendTo(packet, address);
+		return sendPacket(sockets::UdpTransport(udpSocket), address, packet);
 	}
 }
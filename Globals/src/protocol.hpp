@@ -1,22 +1,38 @@
 #pragma once
+#include <atomic>
 #include <tuple>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include "sockets.hpp"
+#include "transport.hpp"
 #include "SFML/System/Vector2.hpp"
 
 namespace protocol
 {
-	inline const char KEY_VALUE_END = '\r';
-	inline const char KEY_VALUE_SEPERATOR = ':';
+	// packets with a different version are ignored
+	inline const unsigned char PROTOCOL_VERSION = 1;
+
+	// the biggest encoded packet, fits a RELIABLE packet full of messages and stays below the usual MTU
+	inline const int MAX_PACKET_SIZE = 1200;
+
+	// DISCOVER packets are padded to this size, and servers only answer probes at least as big as the answer,
+	// so a spoofed probe can't make a server send more bytes than it received
+	inline const int DISCOVER_SIZE = 128;
+
+	// server names are cut to this length, so SERVER_INFO fits in DISCOVER_SIZE
+	inline const int MAX_SERVER_NAME = 64;
 
 	enum class PacketType : char
 	{
 		NO_PACKET,
 		UPDATE_PLAYER,
 		UPDATE_BULLET,
-		CLEAR_BULLETS
+		CLEAR_BULLETS,
+		PLAYER_INPUT,
+		RELIABLE,
+		DISCOVER,
+		SERVER_INFO
 	};
 
 	struct Packet
@@ -25,35 +41,93 @@ namespace protocol
 		int index = -1;
 		sf::Vector2f position;
 		float direction = 0;
+		int sequence = 0;
+		sf::Vector2f input;
+		int tick = 0;
+		// the ReliableChannel packet in RELIABLE packets, the encoded messages::ServerInfo in SERVER_INFO packets, padding in DISCOVER packets
+		std::vector<char> payload;
+		// who sent the packet, set by receivePacket
+		sockets::Address address;
+	};
+
+	/**
+	 * @brief Counts the UDP traffic of the process. Safe to read from any thread.
+	 */
+	struct TrafficStats
+	{
+		std::atomic<uint64_t> packetsSent = 0;
+		std::atomic<uint64_t> bytesSent = 0;
+		std::atomic<uint64_t> packetsReceived = 0;
+		std::atomic<uint64_t> bytesReceived = 0;
 	};
 
+	// traffic of every packet sent and received with sendPacket and receivePacket
+	inline TrafficStats traffic;
+
 	/**
-	 * @brief Receives a key-value pair.
-	 * @param tcpSocket The socket to receive from.
-	 * @return A pair of key and value. If an exception occurs, the key and the value will be empty strings.
+	 * @brief Encodes a packet. Only the fields that its type uses are written.
+	 * @param packet The packet.
+	 * @return The encoded bytes.
 	 */
-	std::pair<std::string, std::string> receiveKeyValue(const sockets::Socket& tcpSocket);
+	std::vector<char> encodePacket(const Packet& packet);
 
 	/**
-	 * @brief Creates a key-value message.
-	 * @param key The key.
-	 * @param value The value.
-	 * @return Key-value message.
+	 * @brief Decodes a packet.
+	 * @param data The encoded bytes.
+	 * @param size The number of bytes.
+	 * @param packet Set to the decoded packet.
+	 * @return Whether the data is a valid packet of the current version.
+	 */
+	bool decodePacket(const char* data, int size, Packet& packet);
+
+	/**
+	 * @brief Rounds a packet's fields to the precision they are sent with,
+	 * so the sender can use exactly what the receiver will decode.
+	 * @param packet The packet.
+	 * @return The packet after encoding and decoding it.
 	 */
-	std::string keyValueMessage(std::string key, std::string value);
+	Packet quantize(const Packet& packet);
 
 	/**
 	 * @brief Receives a Packet.
+	 * Invalid packets are skipped.
+	 * @param transport The transport to receive from.
+	 * @return The packet, or a NO_PACKET packet if there are no packets to receive (or the receive timed out).
+	 */
+	Packet receivePacket(const sockets::Transport& transport);
+
+	/**
+	 * @brief Receives a Packet from a UDP socket.
+	 * Invalid packets are skipped.
 	 * @param udpSocket The socket to receive from.
-	 * @return 
+	 * @return The packet, or a NO_PACKET packet if there are no packets to receive.
 	 */
 	Packet receivePacket(const sockets::Socket& udpSocket);
-	
+
 	/**
 	 * @brief Sends a packet to an address.
+	 * @param transport The transport.
+	 * @param address The address.
+	 * @param packet The packet.
+	 * @return How many bytes were sent.
+	 */
+	int sendPacket(const sockets::Transport& transport, const sockets::Address& address, Packet packet);
+
+	/**
+	 * @brief Sends a packet that is already encoded to an address, for packets that are sent to many addresses or measured before sending.
+	 * @param transport The transport.
+	 * @param address The address.
+	 * @param data The packet, encoded with encodePacket.
+	 * @return How many bytes were sent.
+	 */
+	int sendEncoded(const sockets::Transport& transport, const sockets::Address& address, const std::vector<char>& data);
+
+	/**
+	 * @brief Sends a packet to an address from a UDP socket.
 	 * @param udpSocket The socket. 
 	 * @param address The address.
 	 * @param packet The packet.
+	 * @return How many bytes were sent.
 	 */
-	void sendPacket(const sockets::Socket& udpSocket, const sockets::Address& address, Packet packet);
+	int sendPacket(const sockets::Socket& udpSocket, const sockets::Address& address, Packet packet);
 }
@@ -0,0 +1,149 @@
+#include "serialization.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace serialization
+{
+	void Writer::writeByte(uint8_t value)
+	{
+		data.push_back((char)value);
+	}
+
+	void Writer::writeVarint(uint32_t value)
+	{
+		// 7 bits in every byte, the high bit says if there are more bytes
+		while (value >= 0x80)
+		{
+			writeByte((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		writeByte((uint8_t)value);
+	}
+
+	void Writer::writeSignedVarint(int32_t value)
+	{
+		// zigzag: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+		writeVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+	}
+
+	void Writer::writeFixed(float value, float scale)
+	{
+		writeSignedVarint((int32_t)lroundf(value * scale));
+	}
+
+	void Writer::writeAngle(float angle)
+	{
+		float turns = fmodf(angle / (2 * (float)M_PI), 1.0f);
+		if (turns < 0)
+			turns += 1.0f;
+
+		uint16_t quantized = (uint16_t)lroundf(turns * 65536.0f);
+		writeByte((uint8_t)(quantized & 0xFF));
+		writeByte((uint8_t)(quantized >> 8));
+	}
+
+	void Writer::writeBytes(const std::vector<char>& bytes)
+	{
+		data.insert(data.end(), bytes.begin(), bytes.end());
+	}
+
+	void Writer::writeString(const std::string& str)
+	{
+		writeVarint((uint32_t)str.size());
+		data.insert(data.end(), str.begin(), str.end());
+	}
+
+	const std::vector<char>& Writer::getData() const
+	{
+		return data;
+	}
+
+	Reader::Reader(const char* data, int size) : data(data), size(size), position(0), hasFailed(false) {}
+
+	uint8_t Reader::readByte()
+	{
+		if (position >= size)
+		{
+			hasFailed = true;
+			return 0;
+		}
+		return (uint8_t)data[position++];
+	}
+
+	uint32_t Reader::readVarint()
+	{
+		uint32_t value = 0;
+
+		// a 32 bit varint is at most 5 bytes
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			uint8_t byte = readByte();
+			value |= (uint32_t)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+
+		hasFailed = true;
+		return 0;
+	}
+
+	int32_t Reader::readSignedVarint()
+	{
+		uint32_t value = readVarint();
+		return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+	}
+
+	float Reader::readFixed(float scale)
+	{
+		return readSignedVarint() / scale;
+	}
+
+	float Reader::readAngle()
+	{
+		uint16_t quantized = readByte();
+		quantized |= (uint16_t)readByte() << 8;
+		return quantized / 65536.0f * 2 * (float)M_PI;
+	}
+
+	std::vector<char> Reader::readBytes(int count)
+	{
+		if (count < 0 || count > remaining())
+		{
+			hasFailed = true;
+			return {};
+		}
+
+		std::vector<char> bytes(data + position, data + position + count);
+		position += count;
+		return bytes;
+	}
+
+	std::string Reader::readString()
+	{
+		uint32_t length = readVarint();
+		if (length > (uint32_t)remaining())
+		{
+			hasFailed = true;
+			return "";
+		}
+
+		std::string str(data + position, length);
+		position += length;
+		return str;
+	}
+
+	int Reader::remaining() const
+	{
+		return std::max(size - position, 0);
+	}
+
+	bool Reader::failed() const
+	{
+		return hasFailed;
+	}
+
+	bool Reader::atEnd() const
+	{
+		return position >= size;
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace serialization
+{
+	/**
+	 * @brief Writes values to a byte buffer in a compact form that doesn't depend on the platform.
+	 */
+	class Writer
+	{
+	public:
+		/**
+		 * @brief Writes a single byte.
+		 * @param value The byte.
+		 */
+		void writeByte(uint8_t value);
+
+		/**
+		 * @brief Writes an unsigned integer with as few bytes as possible (7 bits in every byte).
+		 * @param value The integer.
+		 */
+		void writeVarint(uint32_t value);
+
+		/**
+		 * @brief Writes a signed integer as a varint, so small negative numbers also take few bytes.
+		 * @param value The integer.
+		 */
+		void writeSignedVarint(int32_t value);
+
+		/**
+		 * @brief Writes a float as a fixed-point number.
+		 * @param value The float.
+		 * @param scale How many steps there are in 1 (the precision is 1 / scale).
+		 */
+		void writeFixed(float value, float scale);
+
+		/**
+		 * @brief Writes an angle in radians in 2 bytes.
+		 * @param angle The angle.
+		 */
+		void writeAngle(float angle);
+
+		/**
+		 * @brief Writes raw bytes, without their length.
+		 * @param bytes The bytes.
+		 */
+		void writeBytes(const std::vector<char>& bytes);
+
+		/**
+		 * @brief Writes a string with its length before it.
+		 * @param str The string.
+		 */
+		void writeString(const std::string& str);
+
+		/**
+		 * @brief Returns the written bytes.
+		 * @return The written bytes.
+		 */
+		const std::vector<char>& getData() const;
+
+	private:
+		std::vector<char> data;
+	};
+
+	/**
+	 * @brief Reads values that were written by a Writer.
+	 * Reading past the end of the data returns 0 and marks the reader as failed.
+	 */
+	class Reader
+	{
+	public:
+		/**
+		 * @brief Creates a new Reader object.
+		 * @param data The data to read.
+		 * @param size The size of the data.
+		 */
+		Reader(const char* data, int size);
+
+		/**
+		 * @brief Reads a single byte.
+		 * @return The byte.
+		 */
+		uint8_t readByte();
+
+		/**
+		 * @brief Reads an unsigned varint.
+		 * @return The integer.
+		 */
+		uint32_t readVarint();
+
+		/**
+		 * @brief Reads a signed varint.
+		 * @return The integer.
+		 */
+		int32_t readSignedVarint();
+
+		/**
+		 * @brief Reads a fixed-point number.
+		 * @param scale The scale it was written with.
+		 * @return The number.
+		 */
+		float readFixed(float scale);
+
+		/**
+		 * @brief Reads an angle.
+		 * @return The angle in radians (between 0 and 2 pi).
+		 */
+		float readAngle();
+
+		/**
+		 * @brief Reads raw bytes.
+		 * @param count How many bytes to read.
+		 * @return The bytes.
+		 */
+		std::vector<char> readBytes(int count);
+
+		/**
+		 * @brief Reads a string that was written with its length.
+		 * @return The string.
+		 */
+		std::string readString();
+
+		/**
+		 * @brief Returns how many bytes weren't read yet.
+		 * @return The number of bytes left.
+		 */
+		int remaining() const;
+
+		/**
+		 * @brief Checks if a read failed (because the data ended or was invalid).
+		 * @return Whether a read failed.
+		 */
+		bool failed() const;
+
+		/**
+		 * @brief Checks if all the data was read.
+		 * @return Whether all the data was read.
+		 */
+		bool atEnd() const;
+
+	private:
+		const char* data;
+		int size;
+		int position;
+		bool hasFailed;
+	};
+}
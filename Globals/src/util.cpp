@@ -16,9 +16,16 @@ std::vector<std::string> splitString(std::string str, char seperator)
 	return result;
 }
 
+// every thread has its own generator, so seeding one thread doesn't change the others
+static thread_local std::mt19937 generator{ std::random_device{}() };
+
+void seedRandom(unsigned int seed)
+{
+	generator.seed(seed);
+}
+
 int randInt(int min, int max)
 {
-	thread_local std::mt19937 generator{ std::random_device{}() };
 	std::uniform_int_distribution<int> distribution(min, max);
 	return distribution(generator);
 }
@@ -13,6 +13,12 @@
  */
 std::vector<std::string> splitString(std::string str, char seperator);
 
+/**
+ * @brief Seeds the random generator of the calling thread, so the numbers it generates next can be generated again.
+ * @param seed The seed.
+ */
+void seedRandom(unsigned int seed);
+
 /**
  * @brief Generates a random int between min and max (both inclusive).
  * @param min Minimum value (inclusive).
@@ -0,0 +1,80 @@
+#include "BulletPool.hpp"
+#include <cmath>
+
+BulletPool::BulletPool(int lifetimeTicks) : lifetimeTicks(lifetimeTicks)
+{
+	bullets.reserve(CAPACITY);
+}
+
+bool BulletPool::spawn(Handle shooter, sf::Vector2f position, float direction, int rewindTicks)
+{
+	Handle handle = bullets.insert(position.x, position.y, cosf(direction), sinf(direction), lifetimeTicks, shooter, rewindTicks);
+	return handle.index != -1;
+}
+
+void BulletPool::integrate(float distance)
+{
+	int count = size();
+	float* x = bullets.column<X>().data();
+	float* y = bullets.column<Y>().data();
+	const float* directionX = bullets.column<DIRECTION_X>().data();
+	const float* directionY = bullets.column<DIRECTION_Y>().data();
+	int* ttl = bullets.column<TTL>().data();
+
+	// plain loops over separate arrays, so the compiler can vectorize them
+	for (int i = 0; i < count; i++)
+		x[i] += directionX[i] * distance;
+	for (int i = 0; i < count; i++)
+		y[i] += directionY[i] * distance;
+	for (int i = 0; i < count; i++)
+		ttl[i]--;
+}
+
+void BulletPool::kill(int dense)
+{
+	bullets.column<TTL>()[dense] = 0;
+}
+
+void BulletPool::removeDead(const globals::MazeArr& maze)
+{
+	// backwards, because removing moves the last bullet to the removed one's place
+	for (int i = size() - 1; i >= 0; i--)
+	{
+		float x = bullets.column<X>()[i];
+		float y = bullets.column<Y>()[i];
+
+		bool dead =
+			bullets.column<TTL>()[i] <= 0 ||
+			x < 0 || x >= globals::WORLD_WIDTH ||
+			y < 0 || y >= globals::WORLD_HEIGHT ||
+			maze[(int)y][(int)x] == globals::CELL_WALL;
+
+		if (dead)
+			bullets.remove(bullets.handleAt(i));
+	}
+}
+
+int BulletPool::size() const
+{
+	return bullets.size();
+}
+
+Handle BulletPool::handleAt(int dense) const
+{
+	return bullets.handleAt(dense);
+}
+
+sf::Vector2f BulletPool::position(int dense) const
+{
+	return { bullets.column<X>()[dense], bullets.column<Y>()[dense] };
+}
+
+Handle BulletPool::shooter(int dense) const
+{
+	return bullets.column<SHOOTER>()[dense];
+}
+
+int BulletPool::rewindTicks(int dense) const
+{
+	return bullets.column<REWIND>()[dense];
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "SlotMap.hpp"
+#include "globals.hpp"
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief A fixed-capacity pool of bullets. Every field is in its own array (structure of arrays),
+ * and dead bullets are removed by moving the last bullet to their place, so the arrays stay compact.
+ */
+class BulletPool
+{
+public:
+	/**
+	 * @brief Creates a new empty BulletPool object.
+	 * @param lifetimeTicks How many ticks a bullet lives.
+	 */
+	BulletPool(int lifetimeTicks);
+
+	/**
+	 * @brief Adds a bullet.
+	 * @param shooter The handle of the player who shot.
+	 * @param position The bullet's position.
+	 * @param direction The bullet's angle.
+	 * @param rewindTicks How many ticks behind the server the shooter saw the other players.
+	 * @return Whether the bullet was added (false if the pool is full).
+	 */
+	bool spawn(Handle shooter, sf::Vector2f position, float direction, int rewindTicks);
+
+	/**
+	 * @brief Moves all bullets and makes them one tick older.
+	 * @param distance How far every bullet moves.
+	 */
+	void integrate(float distance);
+
+	/**
+	 * @brief Marks a bullet as dead, it will be removed in the next call to removeDead.
+	 * @param dense The bullet's position in the arrays.
+	 */
+	void kill(int dense);
+
+	/**
+	 * @brief Removes bullets that are dead, too old, outside the maze or inside a wall.
+	 * @param maze The maze.
+	 */
+	void removeDead(const globals::MazeArr& maze);
+
+	/**
+	 * @brief Returns the number of bullets.
+	 * @return The number of bullets.
+	 */
+	int size() const;
+
+	/**
+	 * @brief Returns the handle (ID) of a bullet.
+	 * @param dense The bullet's position in the arrays.
+	 * @return The handle of the bullet.
+	 */
+	Handle handleAt(int dense) const;
+
+	/**
+	 * @brief Returns the position of a bullet.
+	 * @param dense The bullet's position in the arrays.
+	 * @return The position.
+	 */
+	sf::Vector2f position(int dense) const;
+
+	/**
+	 * @brief Returns the shooter of a bullet.
+	 * @param dense The bullet's position in the arrays.
+	 * @return The handle of the player who shot.
+	 */
+	Handle shooter(int dense) const;
+
+	/**
+	 * @brief Returns how many ticks behind the server the shooter of a bullet saw the other players.
+	 * @param dense The bullet's position in the arrays.
+	 * @return The rewind ticks.
+	 */
+	int rewindTicks(int dense) const;
+
+	inline static const int CAPACITY = Handle::MAX_INDEX + 1;
+
+private:
+	int lifetimeTicks;
+
+	// columns
+	enum { X, Y, DIRECTION_X, DIRECTION_Y, TTL, SHOOTER, REWIND };
+
+	SlotMap<float, float, float, float, int, Handle, int> bullets;
+};
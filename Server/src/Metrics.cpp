@@ -0,0 +1,234 @@
+#include "Metrics.hpp"
+#include "protocol.hpp"
+#include "logging.hpp"
+
+namespace metrics
+{
+	// buckets for tick phases, in seconds (a tick is 16.7ms)
+	static const std::vector<double> PHASE_BOUNDS = { 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.0167, 0.025, 0.05 };
+
+	/**
+	 * @brief Writes a single value in Prometheus text format.
+	 * @param out The string to write to.
+	 * @param name The name of the metric.
+	 * @param type The type of the metric (counter or gauge).
+	 * @param help A description of the metric.
+	 * @param value The value.
+	 */
+	static void writeValue(std::string& out, const std::string& name, const std::string& type, const std::string& help, double value)
+	{
+		out += "# HELP " + name + " " + help + "\n";
+		out += "# TYPE " + name + " " + type + "\n";
+		out += name + " " + std::to_string(value) + "\n";
+	}
+
+	void Counter::add(uint64_t amount)
+	{
+		value.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	uint64_t Counter::get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+	void Gauge::set(double newValue)
+	{
+		value.store(newValue, std::memory_order_relaxed);
+	}
+
+	double Gauge::get() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+	Histogram::Histogram(std::vector<double> bounds)
+		: bounds(bounds), buckets(std::make_unique<std::atomic<uint64_t>[]>(bounds.size() + 1))
+	{
+		for (int i = 0; i <= bounds.size(); i++)
+			buckets[i] = 0;
+	}
+
+	void Histogram::observe(double value)
+	{
+		int bucket = 0;
+		while (bucket < bounds.size() && value > bounds[bucket])
+			bucket++;
+
+		buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	void Histogram::write(std::string& out, const std::string& name, const std::string& labels) const
+	{
+		std::string prefix = labels.empty() ? "" : labels + ",";
+
+		// Prometheus buckets are cumulative
+		uint64_t cumulative = 0;
+		for (int i = 0; i <= bounds.size(); i++)
+		{
+			cumulative += buckets[i].load(std::memory_order_relaxed);
+			std::string bound = i < bounds.size() ? std::to_string(bounds[i]) : "+Inf";
+			out += name + "_bucket{" + prefix + "le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+		}
+
+		std::string braces = labels.empty() ? "" : "{" + labels + "}";
+		out += name + "_sum" + braces + " " + std::to_string(sum.load(std::memory_order_relaxed)) + "\n";
+		out += name + "_count" + braces + " " + std::to_string(count.load(std::memory_order_relaxed)) + "\n";
+	}
+
+	Timer::Timer(Histogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+	Timer::~Timer()
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		histogram.observe(elapsed.count());
+	}
+
+	ServerMetrics::ServerMetrics()
+		: tickSeconds(PHASE_BOUNDS), handleEventsSeconds(PHASE_BOUNDS), sendPlayersSeconds(PHASE_BOUNDS),
+		updateBulletsSeconds(PHASE_BOUNDS), sendBulletsSeconds(PHASE_BOUNDS), sendTimerUpdateSeconds(PHASE_BOUNDS)
+	{
+	}
+
+	void ServerMetrics::setMaxClients(int newMaxClients)
+	{
+		maxClients = newMaxClients;
+		clients = std::make_unique<ClientMetrics[]>(maxClients);
+	}
+
+	ClientMetrics* ServerMetrics::client(int index)
+	{
+		if (index < 0 || index >= maxClients)
+			return nullptr;
+		return &clients[index];
+	}
+
+	void ServerMetrics::writeClientGauge(std::string& out, const std::string& name, const std::string& help, Gauge ClientMetrics::* gauge) const
+	{
+		out += "# HELP " + name + " " + help + "\n";
+		out += "# TYPE " + name + " gauge\n";
+
+		// a series for every connected client, labeled with its slot index
+		for (int i = 0; i < maxClients; i++)
+		{
+			if (clients[i].connected.load(std::memory_order_relaxed))
+				out += name + "{client=\"" + std::to_string(i) + "\"} " + std::to_string((clients[i].*gauge).get()) + "\n";
+		}
+	}
+
+	std::string ServerMetrics::toPrometheus() const
+	{
+		std::string out;
+
+		out += "# HELP chaos_tick_phase_seconds Time spent in every phase of a server tick.\n";
+		out += "# TYPE chaos_tick_phase_seconds histogram\n";
+		tickSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"tick\"");
+		handleEventsSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"handleEvents\"");
+		sendPlayersSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"sendPlayers\"");
+		updateBulletsSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"updateBullets\"");
+		sendBulletsSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"sendBullets\"");
+		sendTimerUpdateSeconds.write(out, "chaos_tick_phase_seconds", "phase=\"sendTimerUpdate\"");
+
+		writeValue(out, "chaos_tick_overruns_total", "counter", "Ticks that took longer than a tick.", tickOverruns.get());
+
+		const protocol::TrafficStats& traffic = protocol::traffic;
+		writeValue(out, "chaos_udp_packets_received_total", "counter", "UDP packets received.", traffic.packetsReceived.load());
+		writeValue(out, "chaos_udp_bytes_received_total", "counter", "UDP bytes received.", traffic.bytesReceived.load());
+		writeValue(out, "chaos_udp_packets_sent_total", "counter", "UDP packets sent.", traffic.packetsSent.load());
+		writeValue(out, "chaos_udp_bytes_sent_total", "counter", "UDP bytes sent.", traffic.bytesSent.load());
+
+		writeValue(out, "chaos_udp_packets_per_tick", "gauge", "UDP packets handled in the last tick.", packetsPerTick.get());
+		writeValue(out, "chaos_udp_receive_queue_bytes", "gauge", "Bytes waiting in the UDP socket after handling events.", receiveQueueBytes.get());
+		writeValue(out, "chaos_active_bullets", "gauge", "Bullets in the game.", activeBullets.get());
+		writeValue(out, "chaos_connected_clients", "gauge", "Connected clients.", connectedClients.get());
+
+		writeClientGauge(out, "chaos_client_rtt_seconds", "Smoothed round trip time of every client.", &ClientMetrics::rtt);
+		writeClientGauge(out, "chaos_client_jitter_seconds", "Round trip time deviation of every client.", &ClientMetrics::jitter);
+		writeClientGauge(out, "chaos_client_loss_ratio", "Part of the reliable packets to every client that were lost.", &ClientMetrics::loss);
+		writeClientGauge(out, "chaos_client_send_rate_bytes", "Bytes per second the server can send to every client.", &ClientMetrics::sendRate);
+
+		return out;
+	}
+
+	Exporter::Exporter(const ServerMetrics& serverMetrics) : serverMetrics(serverMetrics), running(false) {}
+
+	Exporter::~Exporter()
+	{
+		stop();
+	}
+
+	void Exporter::start(sockets::Address address)
+	{
+		socket = sockets::Socket(sockets::Protocol::TCP);
+		try
+		{
+			socket.bind(address);
+			socket.listen(4);
+		}
+		catch (sockets::exception&)
+		{
+			socket.close();
+			throw;
+		}
+
+		running = true;
+		thread = std::thread(&Exporter::serve, this);
+	}
+
+	void Exporter::stop()
+	{
+		if (!running)
+			return;
+
+		// closing the socket makes accept fail, which ends the thread
+		running = false;
+		socket.close();
+		thread.join();
+	}
+
+	void Exporter::serve()
+	{
+		while (running)
+		{
+			try
+			{
+				auto [client, address] = socket.accept();
+
+				// a client that never sends its request mustn't hold the thread, and stop() with it
+				client.setTimeout(REQUEST_TIMEOUT);
+
+				try
+				{
+					// the request itself doesn't matter
+					client.recv(1024);
+
+					std::string body = serverMetrics.toPrometheus();
+					std::string response =
+						"HTTP/1.1 200 OK\r\n"
+						"Content-Type: text/plain; version=0.0.4\r\n"
+						"Content-Length: " + std::to_string(body.size()) + "\r\n"
+						"Connection: close\r\n\r\n" + body;
+
+					int sent = 0;
+					while (sent < response.size())
+						sent += client.send(response.data() + sent, response.size() - sent);
+				}
+				catch (sockets::exception&)
+				{
+					// the request timed out or the connection failed
+					client.close();
+					throw;
+				}
+
+				client.close();
+			}
+			catch (sockets::exception& err)
+			{
+				if (running)
+					logging::error("Metrics error", { { "error", err.what() } });
+			}
+		}
+	}
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sockets.hpp"
+
+namespace metrics
+{
+	// how long the exporter waits for a scraper's request before dropping it
+	inline const float REQUEST_TIMEOUT = 1;
+
+	/**
+	 * @brief A number that only goes up. Safe to use from any thread without locks.
+	 */
+	class Counter
+	{
+	public:
+		/**
+		 * @brief Adds to the counter.
+		 * @param amount How much to add.
+		 */
+		void add(uint64_t amount = 1);
+
+		/**
+		 * @brief Returns the value of the counter.
+		 * @return The value of the counter.
+		 */
+		uint64_t get() const;
+
+	private:
+		std::atomic<uint64_t> value = 0;
+	};
+
+	/**
+	 * @brief A number that can go up and down. Safe to use from any thread without locks.
+	 */
+	class Gauge
+	{
+	public:
+		/**
+		 * @brief Sets the value of the gauge.
+		 * @param newValue The new value.
+		 */
+		void set(double newValue);
+
+		/**
+		 * @brief Returns the value of the gauge.
+		 * @return The value of the gauge.
+		 */
+		double get() const;
+
+	private:
+		std::atomic<double> value = 0;
+	};
+
+	/**
+	 * @brief Counts values in buckets. Safe to use from any thread without locks.
+	 */
+	class Histogram
+	{
+	public:
+		/**
+		 * @brief Creates a new Histogram object.
+		 * @param bounds The upper bound of every bucket, from lowest to highest (an infinite bucket is added).
+		 */
+		Histogram(std::vector<double> bounds);
+
+		/**
+		 * @brief Adds a value.
+		 * @param value The value.
+		 */
+		void observe(double value);
+
+		/**
+		 * @brief Writes the histogram in Prometheus text format.
+		 * @param out The string to write to.
+		 * @param name The name of the metric.
+		 * @param labels The labels of the metric (for example 'phase="tick"'), can be empty.
+		 */
+		void write(std::string& out, const std::string& name, const std::string& labels) const;
+
+	private:
+		std::vector<double> bounds;
+		std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+		std::atomic<uint64_t> count = 0;
+		std::atomic<double> sum = 0;
+	};
+
+	/**
+	 * @brief Measures how long a scope takes, and adds it to a histogram in seconds.
+	 */
+	class Timer
+	{
+	public:
+		/**
+		 * @brief Starts measuring.
+		 * @param histogram The histogram to add the time to.
+		 */
+		Timer(Histogram& histogram);
+
+		/**
+		 * @brief Stops measuring and adds the time to the histogram.
+		 */
+		~Timer();
+
+	private:
+		Histogram& histogram;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/**
+	 * @brief The connection quality of a client.
+	 */
+	struct ClientMetrics
+	{
+		std::atomic<bool> connected = false;
+		Gauge rtt;
+		Gauge jitter;
+		Gauge loss;
+		// bytes per second the server allows itself to send to the client
+		Gauge sendRate;
+	};
+
+	/**
+	 * @brief All the metrics of the server.
+	 */
+	struct ServerMetrics
+	{
+		/**
+		 * @brief Creates a new ServerMetrics object.
+		 */
+		ServerMetrics();
+
+		/**
+		 * @brief Sets how many clients there can be. Must be called before the exporter starts.
+		 * @param maxClients The most clients (client indices are below it).
+		 */
+		void setMaxClients(int maxClients);
+
+		/**
+		 * @brief Returns the metrics of a client.
+		 * @param index The slot index of the client.
+		 * @return The metrics, or nullptr if the index is too big.
+		 */
+		ClientMetrics* client(int index);
+
+		/**
+		 * @brief Writes all the metrics in Prometheus text format.
+		 * @return The metrics.
+		 */
+		std::string toPrometheus() const;
+
+		// time of every phase of a tick
+		Histogram tickSeconds;
+		Histogram handleEventsSeconds;
+		Histogram sendPlayersSeconds;
+		Histogram updateBulletsSeconds;
+		Histogram sendBulletsSeconds;
+		Histogram sendTimerUpdateSeconds;
+
+		// ticks that took longer than a tick
+		Counter tickOverruns;
+
+		// UDP packets handled in the last tick
+		Gauge packetsPerTick;
+		// bytes waiting in the UDP socket after handling events
+		Gauge receiveQueueBytes;
+
+		Gauge activeBullets;
+		Gauge connectedClients;
+
+	private:
+		/**
+		 * @brief Writes a gauge of every connected client in Prometheus text format.
+		 * @param out The string to write to.
+		 * @param name The name of the metric.
+		 * @param help A description of the metric.
+		 * @param gauge Which gauge of the clients to write.
+		 */
+		void writeClientGauge(std::string& out, const std::string& name, const std::string& help, Gauge ClientMetrics::* gauge) const;
+
+		std::unique_ptr<ClientMetrics[]> clients;
+		int maxClients = 0;
+	};
+
+	/**
+	 * @brief Serves metrics over HTTP from its own thread.
+	 */
+	class Exporter
+	{
+	public:
+		/**
+		 * @brief Creates a new Exporter object.
+		 * @param serverMetrics The metrics to serve.
+		 */
+		Exporter(const ServerMetrics& serverMetrics);
+
+		/**
+		 * @brief Stops the exporter.
+		 */
+		~Exporter();
+
+		/**
+		 * @brief Starts serving metrics on an address. Every request gets the metrics, whatever its path.
+		 * @param address The address to listen on.
+		 */
+		void start(sockets::Address address);
+
+		/**
+		 * @brief Stops serving metrics and waits for the thread to finish.
+		 */
+		void stop();
+
+	private:
+		/**
+		 * @brief Accepts connections and answers them until the socket is closed.
+		 */
+		void serve();
+
+		const ServerMetrics& serverMetrics;
+		sockets::Socket socket;
+		std::thread thread;
+		std::atomic<bool> running;
+	};
+}
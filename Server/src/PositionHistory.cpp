@@ -0,0 +1,39 @@
+#include "PositionHistory.hpp"
+#include <algorithm>
+
+PositionHistory::PositionHistory(int maxPlayers)
+	: maxPlayers(maxPlayers), currentRow(0), rowTicks(HISTORY_TICKS, -1),
+	positions(HISTORY_TICKS * maxPlayers), recorded(HISTORY_TICKS * maxPlayers, false)
+{
+}
+
+void PositionHistory::beginTick(int tick)
+{
+	currentRow = tick & (HISTORY_TICKS - 1);
+	rowTicks[currentRow] = tick;
+
+	// forget the players of the overwritten tick
+	std::fill(recorded.begin() + currentRow * maxPlayers, recorded.begin() + (currentRow + 1) * maxPlayers, false);
+}
+
+void PositionHistory::record(int index, sf::Vector2f position)
+{
+	if (index < 0 || index >= maxPlayers)
+		return;
+
+	positions[currentRow * maxPlayers + index] = position;
+	recorded[currentRow * maxPlayers + index] = true;
+}
+
+bool PositionHistory::get(int tick, int index, sf::Vector2f& position) const
+{
+	if (index < 0 || index >= maxPlayers || tick < 0)
+		return false;
+
+	int row = tick & (HISTORY_TICKS - 1);
+	if (rowTicks[row] != tick || !recorded[row * maxPlayers + index])
+		return false;
+
+	position = positions[row * maxPlayers + index];
+	return true;
+}
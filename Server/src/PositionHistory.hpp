@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "SFML/System/Vector2.hpp"
+
+/**
+ * @brief Keeps the positions of all players in the last ticks, to check hits against where a shooter saw the players.
+ * The positions are stored in one array, tick after tick, so all players of a tick are next to each other in memory.
+ */
+class PositionHistory
+{
+public:
+	/**
+	 * @brief Creates a new PositionHistory object.
+	 * @param maxPlayers How many player indices to keep (indices 0 to maxPlayers - 1).
+	 */
+	PositionHistory(int maxPlayers = 0);
+
+	/**
+	 * @brief Starts recording a new tick, overwriting the oldest one.
+	 * @param tick The tick.
+	 */
+	void beginTick(int tick);
+
+	/**
+	 * @brief Records a player's position in the current tick.
+	 * @param index The player's index.
+	 * @param position The player's position.
+	 */
+	void record(int index, sf::Vector2f position);
+
+	/**
+	 * @brief Gets a player's position in a previous tick.
+	 * @param tick The tick.
+	 * @param index The player's index.
+	 * @param position Set to the player's position if it was found.
+	 * @return Whether the position is in the history.
+	 */
+	bool get(int tick, int index, sf::Vector2f& position) const;
+
+	// how many ticks are kept (power of 2), more than globals::MAX_REWIND_TICKS
+	inline static const int HISTORY_TICKS = 64;
+
+private:
+	int maxPlayers;
+
+	// row of the current tick
+	int currentRow;
+
+	// the tick of each row, -1 if the row is empty
+	std::vector<int> rowTicks;
+
+	std::vector<sf::Vector2f> positions;
+	std::vector<char> recorded;
+};
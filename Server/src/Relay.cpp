@@ -0,0 +1,126 @@
+#include "Relay.hpp"
+#include <thread>
+#include "protocol.hpp"
+#include "messages.hpp"
+#include "globals.hpp"
+#include "logging.hpp"
+
+Relay::Relay(double delay, const std::string& token)
+	: delay(delay), token(token), hub(MAX_VIEWERS, delay), index(-1), started(false), ended(false)
+{
+}
+
+void Relay::run(const std::string& serverIp)
+{
+	tcpSocket = sockets::Socket(sockets::Protocol::TCP);
+	udpSocket = sockets::Socket(sockets::Protocol::UDP);
+	serverAddress = { serverIp, globals::SPECTATOR_PORT };
+
+	tcpSocket.connect(serverAddress);
+
+	// get available port
+	udpSocket.bind({ "0.0.0.0", 0 });
+	udpSocket.setBlocking(false);
+	if (!token.empty())
+		messages::send(tcpSocket, messages::Watch{ token });
+	messages::send(tcpSocket, messages::Udp{ udpSocket.getSocketName().port });
+
+	hub.start({ "0.0.0.0", globals::SPECTATOR_PORT });
+	logging::info("Relaying match", { { "server", serverIp }, { "delay", std::to_string(delay) } });
+
+	const auto timeout = std::chrono::duration<double>(SERVER_TIMEOUT);
+
+	while (!ended)
+	{
+		receiveTCP();
+		receiveUDP();
+		sendReliable();
+
+		if (started && clock::now() - lastHeard > timeout)
+		{
+			logging::warning("Server stopped sending, ending relay");
+			break;
+		}
+
+		// twice a tick, so the snapshots aren't held longer than needed
+		std::this_thread::sleep_for(std::chrono::milliseconds(1000 / globals::SERVER_TICKS / 2));
+	}
+
+	// the viewers get the end of the match only after the delay
+	std::this_thread::sleep_for(std::chrono::duration<double>(delay + 1));
+
+	try
+	{
+		messages::send(tcpSocket, messages::Close{});
+	}
+	catch (sockets::exception& err)
+	{
+		logging::warning("Can't close relay connection", { { "error", err.what() } });
+	}
+	tcpSocket.close();
+	udpSocket.close();
+	hub.stop();
+
+	logging::info("Relay ended");
+}
+
+void Relay::receiveTCP()
+{
+	// a message that started arriving is read whole
+	if (tcpSocket.available() == 0)
+		return;
+
+	messages::dispatch(messages::receive(tcpSocket), messages::Handlers{
+		[&](const messages::Index& message) { index = message.index; },
+		[&](const messages::Player& player) { hub.addPlayer(player.name); },
+		[&](const messages::Soon&) { hub.soon(); },
+		[&](const messages::Start& start)
+		{
+			hub.startGame(start.maze);
+			started = true;
+			lastHeard = clock::now();
+		}
+	});
+}
+
+void Relay::receiveUDP()
+{
+	protocol::Packet packet;
+	while ((packet = protocol::receivePacket(udpSocket)).type != protocol::PacketType::NO_PACKET)
+	{
+		if (!(packet.address == serverAddress))
+			continue;
+
+		lastHeard = clock::now();
+
+		if (packet.type != protocol::PacketType::RELIABLE)
+		{
+			hub.publish(packet);
+			continue;
+		}
+
+		if (!channel.readPacket(packet.payload))
+			continue;
+
+		ReliableChannel::Message message;
+		while (channel.receive(message))
+		{
+			// passed on as it is, without decoding it
+			hub.publishMessage(message);
+			if (messages::is<messages::End>(message))
+				ended = true;
+		}
+	}
+}
+
+void Relay::sendReliable()
+{
+	protocol::Packet packet;
+	packet.payload = channel.writePacket();
+	if (packet.payload.empty())
+		return;
+
+	packet.type = protocol::PacketType::RELIABLE;
+	packet.index = index;
+	protocol::sendPacket(udpSocket, serverAddress, packet);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <chrono>
+#include "sockets.hpp"
+#include "ReliableChannel.hpp"
+#include "SpectatorHub.hpp"
+
+/**
+ * @brief Watches a match on a game server as a spectator and sends it on to many viewers from its own threads,
+ * so the game server sends the match once no matter how many viewers watch it.
+ * Viewers connect to a relay the same way they connect to a server, so relays can also watch other relays.
+ */
+class Relay
+{
+public:
+	// how many viewers can watch through one relay
+	inline static const int MAX_VIEWERS = 512;
+
+	// how many seconds the match is held before it is sent to the viewers, if no delay is given
+	inline static const double DEFAULT_DELAY = 2.0;
+
+	// the server is considered gone if nothing came from it for this many seconds during the game
+	inline static const float SERVER_TIMEOUT = 10;
+
+	/**
+	 * @brief Creates a new Relay object.
+	 * @param delay How many seconds the match is held before it is sent to the viewers.
+	 * @param token The spectator token the game server logged, or an empty string to watch another relay.
+	 */
+	Relay(double delay = DEFAULT_DELAY, const std::string& token = "");
+
+	/**
+	 * @brief Connects to a game server and relays its match until it ends.
+	 * Throws sockets::exception if the server can't be reached.
+	 * @param serverIp The IP of the game server (or of another relay).
+	 */
+	void run(const std::string& serverIp);
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief Receives the lobby messages of the server and passes them to the viewers.
+	 */
+	void receiveTCP();
+
+	/**
+	 * @brief Receives the snapshots and events of the server and publishes them to the viewers.
+	 * Packets that didn't come from the server's address are dropped, so nobody else can send the viewers a fake match.
+	 */
+	void receiveUDP();
+
+	/**
+	 * @brief Acks the events that were received.
+	 */
+	void sendReliable();
+
+	double delay;
+	std::string token;
+	SpectatorHub hub;
+
+	sockets::Socket tcpSocket;
+	sockets::Socket udpSocket;
+	sockets::Address serverAddress;
+
+	ReliableChannel channel;
+	// the relay's index in the server, for the acks
+	int index;
+
+	bool started;
+	bool ended;
+	// when something last came from the server
+	clock::time_point lastHeard;
+};
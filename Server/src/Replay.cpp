@@ -0,0 +1,169 @@
+#include "Replay.hpp"
+#include "serialization.hpp"
+#include <bit>
+#include <iterator>
+
+namespace replay
+{
+	/**
+	 * @brief Writes a float exactly, because a rounded position would make the simulation different.
+	 * @param writer The writer.
+	 * @param value The float.
+	 */
+	static void writeFloat(serialization::Writer& writer, float value)
+	{
+		uint32_t bits = std::bit_cast<uint32_t>(value);
+		for (int i = 0; i < 4; i++)
+			writer.writeByte((bits >> (i * 8)) & 0xFF);
+	}
+
+	/**
+	 * @brief Reads a float that was written by writeFloat.
+	 * @param reader The reader.
+	 * @return The float.
+	 */
+	static float readFloat(serialization::Reader& reader)
+	{
+		uint32_t bits = 0;
+		for (int i = 0; i < 4; i++)
+			bits |= (uint32_t)reader.readByte() << (i * 8);
+		return std::bit_cast<float>(bits);
+	}
+
+	bool Recorder::open(const std::string& path, unsigned int seed, int numberOfPlayers)
+	{
+		std::lock_guard lock(mutex);
+
+		file.open(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		serialization::Writer writer;
+		for (char c : MAGIC)
+			writer.writeByte(c);
+		writer.writeVarint(VERSION);
+		writer.writeVarint(seed);
+		writer.writeVarint(numberOfPlayers);
+
+		file.write(writer.getData().data(), writer.getData().size());
+		return (bool)file;
+	}
+
+	void Recorder::write(const Record& record)
+	{
+		serialization::Writer writer;
+		writer.writeVarint(record.tick);
+		writer.writeByte((uint8_t)record.type);
+
+		switch (record.type)
+		{
+		case RecordType::JOIN:
+			writer.writeVarint(record.id);
+			writer.writeString(record.name);
+			writeFloat(writer, record.position.x);
+			writeFloat(writer, record.position.y);
+			break;
+		case RecordType::LEAVE:
+			writer.writeVarint(record.id);
+			break;
+		case RecordType::PACKET:
+			writer.writeVarint((uint32_t)record.data.size());
+			writer.writeBytes(record.data);
+			break;
+		case RecordType::TIMER:
+			break;
+		case RecordType::CHECKSUM:
+			writer.writeVarint(record.checksum);
+			break;
+		}
+
+		std::lock_guard lock(mutex);
+		if (file.is_open())
+			file.write(writer.getData().data(), writer.getData().size());
+	}
+
+	void Recorder::close()
+	{
+		std::lock_guard lock(mutex);
+		file.close();
+	}
+
+	bool Recorder::isOpen() const
+	{
+		return file.is_open();
+	}
+
+	bool Reader::open(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		serialization::Reader reader(data.data(), (int)data.size());
+		for (char c : MAGIC)
+		{
+			if (reader.readByte() != (uint8_t)c)
+				return false;
+		}
+
+		if (reader.readVarint() != VERSION)
+			return false;
+		seed = reader.readVarint();
+		numberOfPlayers = reader.readVarint();
+
+		offset = (int)data.size() - reader.remaining();
+		return !reader.failed();
+	}
+
+	bool Reader::next(Record& record)
+	{
+		serialization::Reader reader(data.data() + offset, (int)data.size() - offset);
+		if (reader.atEnd())
+			return false;
+
+		record = Record();
+		record.tick = reader.readVarint();
+		record.type = (RecordType)reader.readByte();
+
+		switch (record.type)
+		{
+		case RecordType::JOIN:
+			record.id = reader.readVarint();
+			record.name = reader.readString();
+			record.position.x = readFloat(reader);
+			record.position.y = readFloat(reader);
+			break;
+		case RecordType::LEAVE:
+			record.id = reader.readVarint();
+			break;
+		case RecordType::PACKET:
+			record.data = reader.readBytes(reader.readVarint());
+			break;
+		case RecordType::TIMER:
+			break;
+		case RecordType::CHECKSUM:
+			record.checksum = reader.readVarint();
+			break;
+		default:
+			return false;
+		}
+
+		if (reader.failed())
+			return false;
+
+		offset = (int)data.size() - reader.remaining();
+		return true;
+	}
+
+	unsigned int Reader::getSeed() const
+	{
+		return seed;
+	}
+
+	int Reader::getNumberOfPlayers() const
+	{
+		return numberOfPlayers;
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include "SFML/System/Vector2.hpp"
+
+namespace replay
+{
+	// the first bytes of every replay file
+	inline const std::string MAGIC = "CCRP";
+	// changes with the simulation too, older replays wouldn't play the same
+	inline const int VERSION = 3;
+
+	enum class RecordType : uint8_t
+	{
+		JOIN,		// a player joined: id, name and position
+		LEAVE,		// a player left: id
+		PACKET,		// a packet from a client was handled: data
+		TIMER,		// a second of the game timer passed
+		CHECKSUM	// the state of the game at the end of the tick: checksum
+	};
+
+	/**
+	 * @brief Something that happened in the match. Only the fields of the record's type are used.
+	 */
+	struct Record
+	{
+		// the tick it happened in, 0 before the game started
+		int tick = 0;
+		RecordType type = RecordType::TIMER;
+		// the player's ID
+		int id = 0;
+		std::string name;
+		sf::Vector2f position;
+		// the encoded packet
+		std::vector<char> data;
+		uint32_t checksum = 0;
+	};
+
+	/**
+	 * @brief Appends the records of a match to a file, in the order they happened.
+	 * The file starts with the seed of the maze, so the match can be simulated again from the records.
+	 */
+	class Recorder
+	{
+	public:
+		/**
+		 * @brief Creates the file and writes its header.
+		 * @param path The path of the file.
+		 * @param seed The seed the maze was generated with.
+		 * @param numberOfPlayers How many players the match is for.
+		 * @return Whether the file was created.
+		 */
+		bool open(const std::string& path, unsigned int seed, int numberOfPlayers);
+
+		/**
+		 * @brief Appends a record to the file. Does nothing if the file isn't open. Can be called from any thread.
+		 * @param record The record.
+		 */
+		void write(const Record& record);
+
+		/**
+		 * @brief Writes what is left and closes the file.
+		 */
+		void close();
+
+		/**
+		 * @brief Checks if the file is open.
+		 * @return Whether records are written.
+		 */
+		bool isOpen() const;
+
+	private:
+		std::ofstream file;
+		std::mutex mutex;
+	};
+
+	/**
+	 * @brief Reads the records of a file that was written by a Recorder.
+	 * A record that was cut in the middle (the server stopped while writing it) ends the file.
+	 */
+	class Reader
+	{
+	public:
+		/**
+		 * @brief Reads the file and its header.
+		 * @param path The path of the file.
+		 * @return Whether the file is a replay of a version that can be read.
+		 */
+		bool open(const std::string& path);
+
+		/**
+		 * @brief Reads the next record.
+		 * @param record The record that was read.
+		 * @return Whether there was a record.
+		 */
+		bool next(Record& record);
+
+		/**
+		 * @brief Returns the seed the maze was generated with.
+		 * @return The seed.
+		 */
+		unsigned int getSeed() const;
+
+		/**
+		 * @brief Returns how many players the match was for.
+		 * @return The number of players.
+		 */
+		int getNumberOfPlayers() const;
+
+	private:
+		std::vector<char> data;
+		// where the next record starts in data
+		int offset = 0;
+		unsigned int seed = 0;
+		int numberOfPlayers = 0;
+	};
+}
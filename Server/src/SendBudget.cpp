@@ -0,0 +1,36 @@
+#include "SendBudget.hpp"
+#include <algorithm>
+
+void SendBudget::update(float seconds, const ReliableChannel::Stats& stats)
+{
+	tokens = std::min(tokens + rate * seconds, rate * BURST_SECONDS);
+
+	if (stats.measured && (minRtt == 0 || stats.rtt < minRtt))
+		minRtt = stats.rtt;
+
+	sinceAdapt += seconds;
+	if (sinceAdapt < ADAPT_INTERVAL)
+		return;
+	sinceAdapt = 0;
+
+	bool congested = stats.loss > MAX_LOSS || (stats.measured && stats.rtt > minRtt + MAX_QUEUE_DELAY);
+	if (congested)
+		rate = std::max(rate * RATE_DECREASE, MIN_RATE);
+	else
+		rate = std::min(rate + RATE_INCREASE, MAX_RATE);
+}
+
+bool SendBudget::canSend(int bytes) const
+{
+	return tokens >= bytes + PACKET_OVERHEAD;
+}
+
+void SendBudget::spend(int bytes)
+{
+	tokens -= bytes + PACKET_OVERHEAD;
+}
+
+float SendBudget::getRate() const
+{
+	return rate;
+}
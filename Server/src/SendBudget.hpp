@@ -0,0 +1,69 @@
+#pragma once
+#include "ReliableChannel.hpp"
+
+/**
+ * @brief A token bucket that limits how many bytes per second are sent to a client.
+ * The rate adapts to the connection: it grows slowly while the connection is good,
+ * and shrinks quickly when packets are lost or the round trip time grows (packets wait in a queue somewhere).
+ */
+class SendBudget
+{
+public:
+	// bytes per second
+	inline static const float START_RATE = 64000;
+	inline static const float MIN_RATE = 8000;
+	inline static const float MAX_RATE = 256000;
+
+	// how many seconds of sending can be saved up
+	inline static const float BURST_SECONDS = 0.05f;
+
+	// how often the rate changes
+	inline static const float ADAPT_INTERVAL = 0.5f;
+
+	// how much the rate grows every interval while the connection is good
+	inline static const float RATE_INCREASE = 8000;
+
+	// how much the rate is multiplied by when the connection is congested
+	inline static const float RATE_DECREASE = 0.75f;
+
+	// the connection is congested above this loss...
+	inline static const float MAX_LOSS = 0.05f;
+	// ...or when the round trip time is this much above the lowest one measured
+	inline static const float MAX_QUEUE_DELAY = 0.05f;
+
+	// the IP and UDP headers of every packet
+	inline static const int PACKET_OVERHEAD = 28;
+
+	/**
+	 * @brief Adds the tokens of time that passed, and adapts the rate to the connection.
+	 * @param seconds How many seconds passed.
+	 * @param stats The quality of the connection.
+	 */
+	void update(float seconds, const ReliableChannel::Stats& stats);
+
+	/**
+	 * @brief Checks if a packet can be sent.
+	 * @param bytes The size of the packet (without headers).
+	 * @return Whether there are enough tokens.
+	 */
+	bool canSend(int bytes) const;
+
+	/**
+	 * @brief Takes the tokens of a sent packet. The tokens can go negative for packets that must be sent anyway.
+	 * @param bytes The size of the packet (without headers).
+	 */
+	void spend(int bytes);
+
+	/**
+	 * @brief Returns how many bytes per second can be sent.
+	 * @return The rate.
+	 */
+	float getRate() const;
+
+private:
+	float rate = START_RATE;
+	float tokens = 0;
+	float sinceAdapt = 0;
+	// the lowest round trip time, when nothing was waiting in queues
+	float minRtt = 0;
+};
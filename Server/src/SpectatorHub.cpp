@@ -0,0 +1,396 @@
+#include "SpectatorHub.hpp"
+#include "messages.hpp"
+#include "logging.hpp"
+#include <algorithm>
+
+SpectatorHub::SpectatorHub(int maxViewers, double delay)
+	: maxViewers(maxViewers), delay(delay), published(QUEUE_CAPACITY), viewerCount(0), isSoon(false), started(false), maze(), running(false)
+{
+}
+
+SpectatorHub::~SpectatorHub()
+{
+	stop();
+}
+
+void SpectatorHub::start(const sockets::Address& address, const std::string& token)
+{
+	this->token = token;
+
+	listenSocket = sockets::Socket(sockets::Protocol::TCP);
+	udpSocket = sockets::Socket(sockets::Protocol::UDP);
+
+	udpSocket.bind(address);
+	udpSocket.setBlocking(false);
+	listenSocket.bind(address);
+	listenSocket.listen(maxViewers);
+
+	running = true;
+	acceptThread = std::thread(&SpectatorHub::acceptViewers, this);
+	ioThread = std::thread(&SpectatorHub::serveViewers, this);
+}
+
+void SpectatorHub::stop()
+{
+	if (!running.exchange(false))
+		return;
+
+	// closing the sockets wakes the threads from accept
+	listenSocket.close();
+	acceptThread.join();
+	ioThread.join();
+	udpSocket.close();
+
+	std::lock_guard lock(viewersMutex);
+	while (viewers.size() > 0)
+		removeViewer(viewers.handleAt(0));
+	for (Handshake& handshake : handshakes)
+		handshake.tcpSocket.close();
+	handshakes.clear();
+}
+
+void SpectatorHub::addPlayer(const std::string& name)
+{
+	std::lock_guard lock(viewersMutex);
+	names.push_back(name);
+	broadcast(messages::encode(messages::Player{ name }));
+}
+
+void SpectatorHub::soon()
+{
+	std::lock_guard lock(viewersMutex);
+	isSoon = true;
+	broadcast(messages::encode(messages::Soon{}));
+}
+
+void SpectatorHub::startGame(const globals::MazeArr& maze)
+{
+	std::lock_guard lock(viewersMutex);
+	started = true;
+	this->maze = maze;
+
+	std::vector<char> start = messages::encode(messages::Start{ maze });
+	for (int i = viewers.size() - 1; i >= 0; i--)
+	{
+		Viewer& viewer = viewers.column<0>()[i];
+		// the viewers had nothing to ack in the lobby
+		viewer.lastHeard = clock::now();
+		try
+		{
+			messages::sendEncoded(viewer.tcpSocket, start);
+		}
+		catch (sockets::exception& err)
+		{
+			logging::warning("Spectator dropped", { { "error", err.what() } });
+			removeViewer(viewers.handleAt(i));
+		}
+	}
+}
+
+void SpectatorHub::publish(const protocol::Packet& packet)
+{
+	if (!running)
+		return;
+
+	// a snapshot that doesn't fit is replaced by the next one anyway
+	published.push({ clock::now(), false, packet, {} });
+}
+
+void SpectatorHub::publishMessage(const ReliableChannel::Message& message)
+{
+	if (!running)
+		return;
+
+	if (!published.push({ clock::now(), true, {}, message }))
+		logging::warning("Spectator event dropped", { { "id", std::to_string(message.empty() ? -1 : (int)(uint8_t)message[0]) } });
+}
+
+int SpectatorHub::getViewerCount() const
+{
+	return viewerCount;
+}
+
+void SpectatorHub::acceptViewers()
+{
+	while (running)
+	{
+		sockets::Socket socket;
+		sockets::Address address;
+
+		try
+		{
+			std::tie(socket, address) = listenSocket.accept();
+		}
+		catch (sockets::exception& err)
+		{
+			if (running)
+				logging::error("Spectator accept error", { { "error", err.what() } });
+			continue;
+		}
+
+		// the I/O thread reads the handshake when it arrives, so a silent connection can't hold this thread
+		socket.setBlocking(false);
+
+		std::lock_guard lock(viewersMutex);
+
+		int fromAddress = (int)std::count_if(handshakes.begin(), handshakes.end(), [&](const Handshake& handshake) { return handshake.address.ip == address.ip; });
+		if (handshakes.size() >= MAX_HANDSHAKES || fromAddress >= HANDSHAKES_PER_ADDRESS)
+		{
+			logging::warning("Spectator rejected, too many handshakes", { { "address", address.ip } });
+			socket.close();
+			continue;
+		}
+
+		handshakes.push_back({ socket, address, clock::now(), {}, token.empty() });
+	}
+}
+
+void SpectatorHub::completeHandshakes()
+{
+	const clock::duration timeout = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(HANDSHAKE_TIMEOUT));
+	clock::time_point now = clock::now();
+
+	// backwards, so removing swaps in a handshake that was already checked
+	for (int i = (int)handshakes.size() - 1; i >= 0; i--)
+	{
+		Handshake& handshake = handshakes[i];
+		bool done = false;
+
+		try
+		{
+			std::vector<std::vector<char>> received;
+			bool open = messages::receiveAvailable(handshake.tcpSocket, handshake.tcpBuffer, received);
+
+			// the token (if the hub has one) and then the UDP port, anything else ends the handshake
+			for (size_t m = 0; m < received.size() && !done; m++)
+			{
+				sockets::Address udpAddress;
+				bool valid = false;
+				messages::dispatch(received[m], messages::Handlers{
+					[&](const messages::Watch& watch)
+					{
+						handshake.authorized = handshake.authorized || watch.token == token;
+						valid = true;
+					},
+					[&](const messages::Udp& udp)
+					{
+						udpAddress = { handshake.address.ip, (unsigned short)udp.port };
+						valid = true;
+						done = true;
+					}
+				});
+
+				if (!valid || (done && !handshake.authorized))
+				{
+					logging::warning("Spectator rejected", { { "address", handshake.address.ip } });
+					done = true;
+					handshake.tcpSocket.close();
+				}
+				else if (done)
+					addViewer(handshake, udpAddress);
+			}
+
+			if (!done && (!open || now - handshake.accepted > timeout))
+			{
+				logging::warning("Spectator handshake failed", { { "address", handshake.address.ip }, { "error", open ? "timed out" : "closed" } });
+				done = true;
+				handshake.tcpSocket.close();
+			}
+		}
+		catch (std::exception& err)
+		{
+			logging::warning("Spectator handshake failed", { { "error", err.what() } });
+			done = true;
+			handshake.tcpSocket.close();
+		}
+
+		if (done)
+		{
+			std::swap(handshakes[i], handshakes.back());
+			handshakes.pop_back();
+		}
+	}
+}
+
+void SpectatorHub::addViewer(Handshake& handshake, const sockets::Address& udpAddress)
+{
+	if (viewers.size() >= maxViewers)
+	{
+		logging::warning("Spectator rejected, too many viewers", { { "address", handshake.address.ip } });
+		handshake.tcpSocket.close();
+		return;
+	}
+
+	// catch up on the lobby, under the lock so no message is missed or sent twice
+	Handle handle = viewers.insert(Viewer{ handshake.tcpSocket, udpAddress, ReliableChannel(), clock::now(), std::move(handshake.tcpBuffer) });
+	try
+	{
+		messages::send(handshake.tcpSocket, messages::Index{ handle.toID() });
+		for (const std::string& name : names)
+			messages::send(handshake.tcpSocket, messages::Player{ name });
+		if (isSoon)
+			messages::send(handshake.tcpSocket, messages::Soon{});
+		if (started)
+			messages::send(handshake.tcpSocket, messages::Start{ maze });
+	}
+	catch (sockets::exception& err)
+	{
+		logging::warning("Spectator handshake failed", { { "error", err.what() } });
+		removeViewer(handle);
+		return;
+	}
+
+	viewerCount = viewers.size();
+	logging::info("Spectator connected", { { "address", handshake.address.ip + ":" + std::to_string(handshake.address.port) }, { "viewers", std::to_string(viewerCount) } });
+}
+
+void SpectatorHub::serveViewers()
+{
+	const clock::duration tickDuration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / globals::SERVER_TICKS));
+	const clock::duration delayDuration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(delay));
+	clock::time_point nextTick = clock::now();
+
+	while (running)
+	{
+		while (std::optional<Item> item = published.pop())
+			delayed.push_back(std::move(*item));
+
+		try
+		{
+			std::lock_guard lock(viewersMutex);
+
+			completeHandshakes();
+			receiveFromViewers();
+
+			clock::time_point due = clock::now() - delayDuration;
+			while (!delayed.empty() && delayed.front().time <= due)
+			{
+				const Item& item = delayed.front();
+				if (item.isMessage)
+				{
+					for (Viewer& viewer : viewers.column<0>())
+						viewer.channel.send(item.message);
+				}
+				else
+				{
+					// encoded once for all the viewers
+					std::vector<char> data = protocol::encodePacket(item.packet);
+					for (Viewer& viewer : viewers.column<0>())
+					{
+						// one bad address shouldn't stop the others
+						try
+						{
+							udpSocket.sendTo(data, viewer.udpAddress);
+						}
+						catch (sockets::exception&)
+						{
+							continue;
+						}
+						protocol::traffic.packetsSent.fetch_add(1, std::memory_order_relaxed);
+						protocol::traffic.bytesSent.fetch_add(data.size(), std::memory_order_relaxed);
+					}
+				}
+				delayed.pop_front();
+			}
+
+			for (int i = 0; i < viewers.size(); i++)
+			{
+				Viewer& viewer = viewers.column<0>()[i];
+
+				protocol::Packet packet;
+				packet.payload = viewer.channel.writePacket();
+				if (packet.payload.empty())
+					continue;
+
+				packet.type = protocol::PacketType::RELIABLE;
+				packet.index = viewers.handleAt(i).toID();
+				protocol::sendPacket(udpSocket, viewer.udpAddress, packet);
+			}
+		}
+		catch (sockets::exception& err)
+		{
+			logging::error("Spectator send error", { { "error", err.what() } });
+		}
+
+		// don't try to catch up after a long freeze
+		nextTick += tickDuration;
+		if (nextTick < clock::now() - tickDuration)
+			nextTick = clock::now();
+		std::this_thread::sleep_until(nextTick);
+	}
+}
+
+void SpectatorHub::receiveFromViewers()
+{
+	clock::time_point now = clock::now();
+
+	protocol::Packet packet;
+	while ((packet = protocol::receivePacket(udpSocket)).type != protocol::PacketType::NO_PACKET)
+	{
+		if (packet.type != protocol::PacketType::RELIABLE)
+			continue;
+
+		Viewer* viewer = viewers.get<0>(Handle::fromID(packet.index));
+		if (viewer == nullptr || !viewer->channel.readPacket(packet.payload))
+			continue;
+
+		viewer->lastHeard = now;
+
+		// viewers don't send messages of their own, only acks
+		ReliableChannel::Message message;
+		while (viewer->channel.receive(message)) {}
+	}
+
+	const clock::duration timeout = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(VIEWER_TIMEOUT + delay));
+
+	// backwards, because removing moves the last viewer to the removed one's place
+	for (int i = viewers.size() - 1; i >= 0; i--)
+	{
+		Viewer& viewer = viewers.column<0>()[i];
+
+		bool left = started && now - viewer.lastHeard > timeout;
+		try
+		{
+			// only whole messages are read, the rest waits in the viewer's buffer
+			std::vector<std::vector<char>> received;
+			if (!messages::receiveAvailable(viewer.tcpSocket, viewer.tcpBuffer, received))
+				left = true;
+			for (const std::vector<char>& message : received)
+			{
+				if (messages::is<messages::Close>(message))
+					left = true;
+			}
+		}
+		catch (sockets::exception&)
+		{
+			left = true;
+		}
+
+		if (left)
+			removeViewer(viewers.handleAt(i));
+	}
+}
+
+void SpectatorHub::broadcast(const std::vector<char>& message)
+{
+	for (int i = viewers.size() - 1; i >= 0; i--)
+	{
+		try
+		{
+			messages::sendEncoded(viewers.column<0>()[i].tcpSocket, message);
+		}
+		catch (sockets::exception& err)
+		{
+			logging::warning("Spectator dropped", { { "error", err.what() } });
+			removeViewer(viewers.handleAt(i));
+		}
+	}
+}
+
+void SpectatorHub::removeViewer(Handle handle)
+{
+	if (Viewer* viewer = viewers.get<0>(handle))
+		viewer->tcpSocket.close();
+	viewers.remove(handle);
+	viewerCount = viewers.size();
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include "sockets.hpp"
+#include "protocol.hpp"
+#include "globals.hpp"
+#include "ReliableChannel.hpp"
+#include "SlotMap.hpp"
+#include "MpscQueue.hpp"
+
+/**
+ * @brief Sends the state of a match to read-only viewers (spectators) from its own threads.
+ * The snapshots and events are published once, and the hub delays them and sends them to every viewer,
+ * so the cost for the publisher doesn't grow with the number of viewers.
+ *
+ * A viewer connects with TCP and sends its UDP port (Udp), after the hub's token (Watch) if it has one. It gets its index (Index), the names of the players (Player),
+ * Soon and Start like a player, then the snapshots over UDP and the events on a reliable channel,
+ * which it acks with RELIABLE packets that have its index. It leaves with Close.
+ */
+class SpectatorHub
+{
+public:
+	// how many published snapshots and events can wait for the I/O thread
+	inline static const int QUEUE_CAPACITY = 8192;
+
+	// how many seconds a new connection has to send its UDP port
+	inline static const float HANDSHAKE_TIMEOUT = 5;
+
+	// how many connections can wait to send their UDP port, in total and from one IP,
+	// so a few silent connections can't keep everyone else out
+	inline static const int MAX_HANDSHAKES = 64;
+	inline static const int HANDSHAKES_PER_ADDRESS = 2;
+
+	// viewers that didn't ack anything for this many seconds (after the delay) during the game are dropped
+	inline static const float VIEWER_TIMEOUT = 10;
+
+	/**
+	 * @brief Creates a new SpectatorHub object.
+	 * @param maxViewers How many viewers can watch at once.
+	 * @param delay How many seconds the snapshots and events are held before they are sent to the viewers.
+	 */
+	SpectatorHub(int maxViewers, double delay);
+
+	/**
+	 * @brief Stops the threads.
+	 */
+	~SpectatorHub();
+
+	/**
+	 * @brief Listens for viewers with TCP and UDP on an address and starts the threads.
+	 * @param address The address.
+	 * @param token The token viewers must send (Watch) before their UDP port, or an empty string to let anyone watch.
+	 */
+	void start(const sockets::Address& address, const std::string& token = "");
+
+	/**
+	 * @brief Disconnects the viewers and stops the threads.
+	 */
+	void stop();
+
+	/**
+	 * @brief Tells the viewers that a player joined the lobby.
+	 * @param name The player's name.
+	 */
+	void addPlayer(const std::string& name);
+
+	/**
+	 * @brief Tells the viewers that the game is about to start.
+	 */
+	void soon();
+
+	/**
+	 * @brief Tells the viewers that the game started and sends them the maze.
+	 * @param maze The maze.
+	 */
+	void startGame(const globals::MazeArr& maze);
+
+	/**
+	 * @brief Publishes a snapshot packet (player or bullets) to all viewers. Can be called from any thread.
+	 * @param packet The packet.
+	 */
+	void publish(const protocol::Packet& packet);
+
+	/**
+	 * @brief Publishes an event to all viewers, on their reliable channels. Can be called from any thread.
+	 * @param message The encoded message.
+	 */
+	void publishMessage(const ReliableChannel::Message& message);
+
+	/**
+	 * @brief Returns how many viewers are watching.
+	 * @return The number of viewers.
+	 */
+	int getViewerCount() const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	// a snapshot packet or an event, with the time it was published
+	struct Item
+	{
+		clock::time_point time;
+		bool isMessage = false;
+		protocol::Packet packet;
+		ReliableChannel::Message message;
+	};
+
+	struct Viewer
+	{
+		sockets::Socket tcpSocket;
+		sockets::Address udpAddress;
+		ReliableChannel channel;
+		// when the viewer last acked something
+		clock::time_point lastHeard;
+		// the start of a TCP message that didn't arrive whole yet
+		std::vector<char> tcpBuffer;
+	};
+
+	// a connection that didn't send its UDP port yet
+	struct Handshake
+	{
+		sockets::Socket tcpSocket;
+		sockets::Address address;
+		clock::time_point accepted;
+		std::vector<char> tcpBuffer;
+		// whether it sent the token, or the hub has none
+		bool authorized = false;
+	};
+
+	/**
+	 * @brief Accepts connections until the hub stops, and leaves their handshakes to the I/O thread. Runs on its own thread.
+	 */
+	void acceptViewers();
+
+	/**
+	 * @brief Turns the connections that sent their UDP port (after the token) into viewers, and closes the ones that took too long
+	 * or sent something else. Never waits for a connection. viewersMutex must be locked.
+	 */
+	void completeHandshakes();
+
+	/**
+	 * @brief Makes a connection that sent its UDP port a viewer, and catches it up on the lobby. viewersMutex must be locked.
+	 * @param handshake The connection.
+	 * @param udpAddress The viewer's UDP address.
+	 */
+	void addViewer(Handshake& handshake, const sockets::Address& udpAddress);
+
+	/**
+	 * @brief Sends the delayed snapshots and events to the viewers every tick until the hub stops. Runs on its own thread.
+	 */
+	void serveViewers();
+
+	/**
+	 * @brief Receives the viewers' acks and Close messages, and drops viewers that left. viewersMutex must be locked.
+	 */
+	void receiveFromViewers();
+
+	/**
+	 * @brief Sends a TCP message to all viewers, and drops the ones that can't get it. viewersMutex must be locked.
+	 * @param message The encoded message.
+	 */
+	void broadcast(const std::vector<char>& message);
+
+	/**
+	 * @brief Closes a viewer's connection and removes it. viewersMutex must be locked.
+	 * @param handle The viewer's handle.
+	 */
+	void removeViewer(Handle handle);
+
+	int maxViewers;
+	double delay;
+	std::string token;
+
+	sockets::Socket listenSocket;
+	sockets::Socket udpSocket;
+
+	MpscQueue<Item> published;
+	// items waiting for their delay to pass, used only by the I/O thread
+	std::deque<Item> delayed;
+
+	SlotMap<Viewer> viewers;
+	std::vector<Handshake> handshakes;
+	mutable std::mutex viewersMutex;
+	std::atomic<int> viewerCount;
+
+	// what happened in the lobby, for viewers that connect later
+	std::vector<std::string> names;
+	bool isSoon;
+	bool started;
+	globals::MazeArr maze;
+
+	std::atomic<bool> running;
+	std::thread acceptThread;
+	std::thread ioThread;
+};
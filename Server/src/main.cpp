@@ -1,76 +1,181 @@
 #include <iostream>
-#include <unordered_map>
 #include <thread>
 #include <chrono>
-#include <functional>
 #include <mutex>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <ctime>
+#include <cstdio>
+#include <bit>
+#include <unordered_map>
 #include "sockets.hpp"
 #include "protocol.hpp"
+#include "messages.hpp"
 #include "globals.hpp"
 #include "maze.hpp"
+#include "VisibilityMap.hpp"
 #include "Player.hpp"
+#include "PositionHistory.hpp"
+#include "SlotMap.hpp"
+#include "BulletPool.hpp"
+#include "ReliableChannel.hpp"
+#include "SendBudget.hpp"
+#include "Metrics.hpp"
+#include "logging.hpp"
+#include "Replay.hpp"
+#include "SpectatorHub.hpp"
+#include "Relay.hpp"
 
 using time_point = std::chrono::steady_clock::time_point;
 
-struct Bullet
-{
-	int playerIndex;
-	sf::Vector2f position;
-	sf::Vector2f direction;
-};
-
+// connection data of a client, the player and score are in their own columns
 struct Client
 {
 	sockets::Socket tcpSocket;
 	sockets::Address udpAddress;
-	Player player = Player({ 0, 0 });
 	std::string name;
-	int score = 0;
+	// sequence of the last input that was simulated
+	int lastInput = 0;
+	// how many inputs can be simulated now, refilled by one every tick up to MAX_INPUT_BURST
+	float inputSteps = 0;
+	// the tick inputSteps was last refilled in
+	int inputStepsTick = 0;
+	// the tick the player last spawned in
+	int spawnTick = 0;
+	// gameplay events to the client
+	ReliableChannel channel;
+	// how many bytes can be sent to the client
+	SendBudget budget;
+	// how much the client needs an update about every player, by the player's slot index
+	std::vector<float> priorities;
+	// the tick the player last shot in
+	int lastShotTick = -1;
+	// the tick the client last got the bullets in
+	int lastBulletsTick = 0;
 };
 
-const int NUMBER_OF_TICKS = 60;
+const int NUMBER_OF_TICKS = globals::SERVER_TICKS;
 const int KILL_PLAYER_SCORE = 100;
 const float BULLET_SPEED = 10.0f;
+// how many seconds a bullet lives if it doesn't hit anything
+const int BULLET_LIFETIME = 3;
 const int SECONDS_BEFORE_START = 2;
 
+static_assert(globals::MAX_REWIND_TICKS < PositionHistory::HISTORY_TICKS, "Hits are checked further back than the position history");
+
+// players further than this get updates every FAR_UPDATE_RATE ticks
+const float NEAR_DISTANCE = 4.0f;
+const int FAR_UPDATE_RATE = 2;
+// players behind walls get updates every OCCLUDED_UPDATE_RATE ticks
+const int OCCLUDED_UPDATE_RATE = 6;
+// players that shot in the last second are more important
+const float SHOOTER_PRIORITY = 2.0f;
+// bullets are sent at least every this many ticks, even over the send budget
+const int MAX_BULLETS_DELAY = 6;
+
+// the client simulates INPUT_TICKS inputs every second, and a few more can arrive together after a delay in the network,
+// the rest are dropped so a client that sends more inputs can't move faster
+const float INPUT_STEPS_PER_TICK = (float)Player::INPUT_TICKS / globals::SERVER_TICKS;
+const float MAX_INPUT_BURST = 10;
+
+// a player can shoot once every this many ticks, so one client can't fill the bullet pool
+const int MIN_SHOT_TICKS = 4;
+// how far from the shooter a bullet can start (the client starts it 0.3 in front of the player),
+// plus how far the shooter can move in the ticks the shot is rewound
+const float MAX_SHOT_DISTANCE = 0.5f;
+
+// metrics are served only to the local machine, on this port unless "--metrics-port <port>" sets another (0 turns them off)
+const unsigned short DEFAULT_METRICS_PORT = 23458;
+
+// the most discovery probes answered every second, in total and from one IP, so probes with a spoofed address can't flood anyone
+const int DISCOVERY_REPLIES_PER_SECOND = 64;
+const int DISCOVERY_REPLIES_PER_SOURCE = 4;
+
+// only a few spectators can watch the server itself, relays send the match on to everyone else
+const int MAX_SPECTATORS = 4;
+
+// the state of the game is recorded in the replay every this many ticks, to find where a replay stops matching the match
+const int CHECKSUM_INTERVAL = NUMBER_OF_TICKS;
+
 // How many players to start the game
 int numberOfPlayers = 0;
 
 // How many players connected
 std::atomic<int> count = 0;
 
-std::vector<Bullet> bullets;
+// the bullet's ID is its handle
+BulletPool bullets(BULLET_LIFETIME * NUMBER_OF_TICKS);
 
 std::vector<std::thread> clientThreads;
 
-// index: client
-std::unordered_map<int, Client> clients;
+// columns of clients
+enum { PLAYER, SCORE, CLIENT };
+
+// the player's index is its handle
+SlotMap<Player, int, Client> clients;
 std::mutex clientsMutex;
 
+metrics::ServerMetrics serverMetrics;
+
+// everything the simulation depends on, to simulate the match again
+replay::Recorder recorder;
+
+// spectators get the match after the same delay as a relay's, so a player can't watch it live next to their game,
+// and only with the token the server logs, so strangers can't take the few places
+SpectatorHub spectators(MAX_SPECTATORS, Relay::DEFAULT_DELAY);
+
 globals::MazeArr maze;
 
+// which cells can see each other, to skip the line of sight checks of players and bullets that can't be seen
+VisibilityMap visibility;
+
+// positions of the players in the last ticks
+PositionHistory history;
+
 // How many seconds left in the game
 int timer = globals::GAME_TIME;
 
+// How many ticks passed since the game started
+int tick = 0;
+
+// the name LAN players see in their server list
+std::string serverName;
+
+// whether players can still join
+std::atomic<bool> gameStarted = false;
+
+// discovery replies in the current second, in total and by source IP (the lobby thread and the simulation can both answer)
+std::mutex discoveryMutex;
+std::chrono::steady_clock::time_point discoverySecond;
+int discoveryReplies = 0;
+std::unordered_map<std::string, int> discoveryRepliesBySource;
+
 /**
- * @brief Executes a function for each UDP address.
- * @param function The function to execute.
+ * @brief Broadcasts a message to all TCP sockets.
+ * @tparam M The type of the message.
+ * @param message The message.
  */
-static void forEachUDP(std::function<void(sockets::Address)> function)
+template<typename M> void broadcast(const M& message)
 {
-	for (auto& [index, client] : clients)
-		function(client.udpAddress);
+	std::vector<char> data = messages::encode(message);
+	for (auto& client : clients.column<CLIENT>())
+		messages::sendEncoded(client.tcpSocket, data);
 }
 
 /**
- * @brief Broadcasts to all TCP sockets.
- * @tparam T The type of data to send.
- * @param data The data to send.
+ * @brief Sends a message to all clients on their reliable channels.
+ * @param message The message.
+ * @param ordered Whether the message must arrive after the ordered messages before it.
  */
-template<typename T> void broadcast(T data)
+template<typename M> void broadcastReliable(const M& message, bool ordered = true)
 {
-	for (auto& [index, client] : clients)
-		client.tcpSocket.send(data);
+	// encoded once for everyone
+	ReliableChannel::Message data = messages::encode(message);
+	for (auto& client : clients.column<CLIENT>())
+		client.channel.send(data, ordered);
+
+	spectators.publishMessage(data);
 }
 
 /**
@@ -95,13 +200,43 @@ static sf::Vector2f randomPosition()
 
 /**
  * @brief Broadcasts a new position of a player.
- * @param index The index of the player.
+ * @param handle The handle of the player.
  * @param position The new position.
  */
-static void broadcastNewPosition(int index, sf::Vector2f position)
+static void broadcastNewPosition(Handle handle, sf::Vector2f position)
+{
+	broadcastReliable(messages::Init{ handle.toID(), position });
+}
+
+/**
+ * @brief Adds a player to the game. clientsMutex must be locked.
+ * @param name The player's name.
+ * @param socket The client's TCP socket.
+ * @param position Where the player starts.
+ * @return The player's handle.
+ */
+static Handle addPlayer(const std::string& name, sockets::Socket socket, sf::Vector2f position)
 {
-	std::string value = std::to_string(index) + " " + std::to_string(position.x) + " " + std::to_string(position.y);
-	broadcast(protocol::keyValueMessage("init", value));
+	Handle handle = clients.insert(Player(position), 0, Client{ socket, {"", 0}, name });
+	recorder.write({ .tick = tick, .type = replay::RecordType::JOIN, .id = handle.toID(), .name = name, .position = position });
+	return handle;
+}
+
+/**
+ * @brief Removes a player from the game and tells the other clients. clientsMutex must be locked.
+ * Handles of players that don't exist (a client that left before sending Player) are ignored.
+ * @param handle The player's handle.
+ */
+static void removePlayer(Handle handle)
+{
+	if (!clients.remove(handle))
+		return;
+	recorder.write({ .tick = tick, .type = replay::RecordType::LEAVE, .id = handle.toID() });
+	if (metrics::ClientMetrics* clientMetrics = serverMetrics.client(handle.index))
+		clientMetrics->connected = false;
+	count--;
+	if (timer > 0)
+		broadcastReliable(messages::Exit{ handle.toID() });
 }
 
 /**
@@ -112,10 +247,13 @@ static void broadcastNewPosition(int index, sf::Vector2f position)
 static void handleClient(sockets::Socket socket, sockets::Address address)
 {
 	sockets::Address udpAddress;
-	int index = 0;
+	Handle handle;
 
-	for (auto& [index, client] : clients)
-		socket.send(protocol::keyValueMessage("player", client.name));
+	{
+		std::lock_guard lock(clientsMutex);
+		for (auto& client : clients.column<CLIENT>())
+			messages::send(socket, messages::Player{ client.name });
+	}
 
 	bool closed = false;
 
@@ -123,129 +261,153 @@ static void handleClient(sockets::Socket socket, sockets::Address address)
 	{
 		try
 		{
-			auto [key, value] = protocol::receiveKeyValue(socket);
-
-			if (key == "player") // value is the name
-			{
-				std::lock_guard lock(clientsMutex);
-
-				index = count;
-				socket.send(protocol::keyValueMessage("index", std::to_string(index)));
-
-				clients[index] = Client{ socket, {"", 0}, Player(randomPosition()), value, 0 };
-
-				broadcast(protocol::keyValueMessage("player", value));
-			}
-
-			else if (key == "udp") // value is the UDP port
-			{
-				std::lock_guard lock(clientsMutex);
-				udpAddress = { address.ip, (unsigned short)std::stoul(value.c_str()) };
-				clients[index].udpAddress = udpAddress;
-			}
+			std::vector<char> message = messages::receive(socket);
 
-			else if (key == "close" || key == "") // no value
+			// the client left, or the connection closed or failed
+			if (message.empty() || messages::is<messages::Close>(message))
 			{
 				std::lock_guard lock(clientsMutex);
 				socket.close();
-				clients.erase(index);
-				std::cout << "Disconnected from " << address.ip << ":" << address.port << std::endl;
+				if (clients.contains(handle))
+					removePlayer(handle);
+				else
+				{
+					// the connection was counted when it was accepted, free its place in the lobby
+					count--;
+				}
+				logging::info("Disconnected", { { "address", address.ip + ":" + std::to_string(address.port) } });
 				closed = true;
-				count--;
-				if (timer > 0)
-					broadcast(protocol::keyValueMessage("exit", std::to_string(index)));
+				continue;
 			}
+
+			messages::dispatch(message, messages::Handlers{
+				[&](const messages::Player& player)
+				{
+					std::lock_guard lock(clientsMutex);
+
+					handle = addPlayer(player.name, socket, randomPosition());
+					messages::send(socket, messages::Index{ handle.toID() });
+
+					broadcast(player);
+					spectators.addPlayer(player.name);
+				},
+				[&](const messages::Udp& udp)
+				{
+					std::lock_guard lock(clientsMutex);
+					udpAddress = { address.ip, (unsigned short)udp.port };
+					if (Client* client = clients.get<CLIENT>(handle))
+						client->udpAddress = udpAddress;
+				}
+			});
 		}
 		catch (sockets::exception& err)
 		{
-			std::cout << err.what() << std::endl;
+			logging::error("Client error", { { "error", err.what() } });
 		}
 	}
 }
 
 /**
  * @brief Handles bullet and player collision.
- * @param index The hit player's index.
- * @param client The client that was hit.
- * @param bullet The bullet that hit the player.
- * @param udpSocket The UDP socket.
+ * @param dense The hit player's position in clients.
+ * @param shooter The handle of the player who shot the bullet.
+ * @param transport The UDP transport.
  */
-static void bulletPlayerCollision(int index, Client& client, Bullet& bullet, const sockets::Socket& udpSocket)
+static void bulletPlayerCollision(int dense, Handle shooter, const sockets::Transport& transport)
 {
-	client.player.lives--;
-	if (client.player.lives == 0)
+	Player& player = clients.column<PLAYER>()[dense];
+	Client& client = clients.column<CLIENT>()[dense];
+
+	player.lives--;
+	if (player.lives == 0)
 	{
-		clients[bullet.playerIndex].tcpSocket.send(protocol::keyValueMessage("score", std::to_string(KILL_PLAYER_SCORE)));
-		clients[bullet.playerIndex].score += KILL_PLAYER_SCORE;
+		// the shooter might have left
+		if (int* score = clients.get<SCORE>(shooter))
+		{
+			// the score is added, so its order doesn't matter
+			clients.get<CLIENT>(shooter)->channel.send(messages::encode(messages::Score{ KILL_PLAYER_SCORE }), false);
+			*score += KILL_PLAYER_SCORE;
+		}
 
-		client.player.pos = randomPosition();
-		client.player.lives = globals::MAX_LIFE;
+		player.pos = randomPosition();
+		player.lives = globals::MAX_LIFE;
+		client.spawnTick = tick;
 
-		broadcastNewPosition(index, client.player.pos);
+		broadcastNewPosition(clients.handleAt(dense), player.pos);
 	}
 	else // if player got hit remove a life and notify the player
-		client.tcpSocket.send(protocol::keyValueMessage("hit", ""));
-
-	// set position to delete the bullet
-	bullet.position.x = -1;
+		client.channel.send(messages::encode(messages::Hit{}));
 }
 
 /**
  * @brief Updates all the bullets and checks for collisions.
- * @param udpSocket The UDP socket.
+ * @param transport The UDP transport.
  */
-static void updateBullets(const sockets::Socket& udpSocket)
+static void updateBullets(const sockets::Transport& transport)
 {
-	for (auto& bullet : bullets)
-	{
-		// move the bullets
-		bullet.position.x += bullet.direction.x * BULLET_SPEED * (1.0f / NUMBER_OF_TICKS);
-		bullet.position.y += bullet.direction.y * BULLET_SPEED * (1.0f / NUMBER_OF_TICKS);
+	// move the bullets
+	bullets.integrate(BULLET_SPEED * (1.0f / NUMBER_OF_TICKS));
 
-		std::lock_guard lock(clientsMutex);
+	std::lock_guard lock(clientsMutex);
 
-		for (auto& [index, client] : clients)
+	for (int bullet = 0; bullet < bullets.size(); bullet++)
+	{
+		// check against the positions the shooter saw
+		int checkTick = tick - bullets.rewindTicks(bullet);
+		Handle shooter = bullets.shooter(bullet);
+		sf::Vector2f bulletPosition = bullets.position(bullet);
+
+		for (int i = 0; i < clients.size(); i++)
 		{
-			sf::Vector2f distance = client.player.pos - bullet.position;
-			if (vecMagnitude(distance) <= 0.2f && index != bullet.playerIndex)
-				bulletPlayerCollision(index, client, bullet, udpSocket);
+			Handle handle = clients.handleAt(i);
+			if (handle == shooter || checkTick < clients.column<CLIENT>()[i].spawnTick)
+				continue;
+
+			sf::Vector2f playerPosition = clients.column<PLAYER>()[i].pos;
+			history.get(checkTick, handle.index, playerPosition);
+
+			sf::Vector2f distance = playerPosition - bulletPosition;
+			if (vecMagnitude(distance) <= 0.2f)
+			{
+				bulletPlayerCollision(i, shooter, transport);
+				bullets.kill(bullet);
+				break;
+			}
 		}
 	}
 
-	// remove bullets that are outside the map or collide with the map
-	bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
-		[](const Bullet& bullet)
-		{
-			if (
-				bullet.position.x < 0 || bullet.position.x >= globals::WORLD_WIDTH ||
-				bullet.position.y < 0 || bullet.position.y >= globals::WORLD_HEIGHT
-				)
-				return false;
-			return maze[(int)bullet.position.y][(int)bullet.position.x] == globals::CELL_WALL;
-		}
-	), bullets.end());
+	// remove bullets that hit something, are too old or are outside the map
+	bullets.removeDead(maze);
 }
 
 /**
- * @brief Sends initial data to all clients.
- * @param udpSocket The UDP socket.
+ * @brief Sends all clients the initial timer and where every player starts.
  */
-static void initGame(const sockets::Socket& udpSocket)
+static void spawnPlayers()
 {
-	std::cout << "Game is starting!" << std::endl;
-
-	// sending to clients to notify them the game began
-	broadcast(protocol::keyValueMessage("start", ""));
-
-	// send maze
-	broadcast(maze);
+	std::lock_guard lock(clientsMutex);
 
 	// send initial timer
-	broadcast(protocol::keyValueMessage("timer", std::to_string(timer)));
+	broadcastReliable(messages::Timer{ timer });
 
 	// send initial starting positions
-	for (auto& [index, client] : clients)
-		broadcastNewPosition(index, client.player.pos);
+	for (int i = 0; i < clients.size(); i++)
+		broadcastNewPosition(clients.handleAt(i), clients.column<PLAYER>()[i].pos);
+}
+
+/**
+ * @brief Sends initial data to all clients.
+ * @param transport The UDP transport.
+ */
+static void initGame(const sockets::Transport& transport)
+{
+	logging::info("Game is starting!");
+
+	// sending to clients to notify them the game began, with the maze
+	broadcast(messages::Start{ maze });
+	spectators.startGame(maze);
+
+	spawnPlayers();
 }
 
 /**
@@ -269,88 +431,510 @@ static bool checkDelay(int& elapsedTime, time_point& lastTimeTick, time_point no
 }
 
 /**
- * @brief Checks if a second has passed, and if so sends all clients the updated timer.
+ * @brief Checks if a second has passed.
  * @param timerTime How much time has elapsed since last second.
  * @param lastTimeTimer Time point of the previous second.
  * @param now Current time point.
- * @return Whether the game ended.
+ * @return Whether a second has passed and changes timerTime and lastTimeTimer accordingly.
  */
-static bool sendTimerUpdate(int& timerTime, time_point& lastTimeTimer, time_point now)
+static bool checkSecond(int& timerTime, time_point& lastTimeTimer, time_point now)
 {
 	timerTime = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTimeTimer).count();
-	if (timerTime >= 1000)
+	if (timerTime < 1000)
+		return false;
+
+	lastTimeTimer = now;
+	timerTime = 0;
+
+	return true;
+}
+
+/**
+ * @brief Counts down a second of the game and sends all clients the updated timer.
+ * @return Whether the game ended.
+ */
+static bool sendTimerUpdate()
+{
+	recorder.write({ .tick = tick, .type = replay::RecordType::TIMER });
+
+	timer--;
+	std::lock_guard lock(clientsMutex);
+	broadcastReliable(messages::Timer{ timer });
+	return timer == 0;
+}
+
+/**
+ * @brief Checks that a packet came from the address of the client its index belongs to,
+ * so nobody else can move, shoot or ack as a player whose index they know.
+ * @param packet The packet.
+ * @return Whether the client exists and sent the packet.
+ */
+static bool isFromClient(const protocol::Packet& packet)
+{
+	std::lock_guard lock(clientsMutex);
+
+	Client* client = clients.get<CLIENT>(Handle::fromID(packet.index));
+	return client != nullptr && client->udpAddress == packet.address;
+}
+
+/**
+ * @brief Simulates a player's input. Old or duplicate inputs are ignored,
+ * and so are inputs over the client's budget of INPUT_STEPS_PER_TICK for every tick that passed.
+ * @param packet The input packet.
+ */
+static void handleInput(const protocol::Packet& packet)
+{
+	std::lock_guard lock(clientsMutex);
+
+	Handle handle = Handle::fromID(packet.index);
+	Client* client = clients.get<CLIENT>(handle);
+	if (client == nullptr || packet.sequence <= client->lastInput)
+		return;
+
+	// don't let bad input break the simulation
+	if (!std::isfinite(packet.direction) || !std::isfinite(packet.input.x) || !std::isfinite(packet.input.y))
+		return;
+
+	client->inputSteps += (tick - client->inputStepsTick) * INPUT_STEPS_PER_TICK;
+	client->inputSteps = client->inputSteps > MAX_INPUT_BURST ? MAX_INPUT_BURST : client->inputSteps;
+	client->inputStepsTick = tick;
+	if (client->inputSteps < 1)
+		return;
+	client->inputSteps--;
+
+	PlayerInput input = { packet.sequence, packet.input, packet.direction };
+	clients.get<PLAYER>(handle)->applyInput(input, maze);
+	client->lastInput = packet.sequence;
+}
+
+/**
+ * @brief Spawns the bullet a player shot. Shots of players that don't exist or that shot less than MIN_SHOT_TICKS ago are dropped,
+ * and a bullet that starts too far from where the shooter was in the tick it saw is moved closer.
+ * @param packet The bullet packet.
+ */
+static void handleShot(const protocol::Packet& packet)
+{
+	std::lock_guard lock(clientsMutex);
+
+	Handle shooter = Handle::fromID(packet.index);
+	Client* client = clients.get<CLIENT>(shooter);
+	if (client == nullptr || (client->lastShotTick >= 0 && tick - client->lastShotTick < MIN_SHOT_TICKS))
+		return;
+
+	// packet.tick is the tick the shooter saw when shooting
+	int rewindTicks = std::clamp(tick - packet.tick, 0, globals::MAX_REWIND_TICKS);
+
+	// the current tick isn't recorded yet
+	sf::Vector2f origin = clients.get<PLAYER>(shooter)->pos;
+	history.get(tick - rewindTicks, shooter.index, origin);
+
+	float reach = MAX_SHOT_DISTANCE + Player::SPEED * rewindTicks / NUMBER_OF_TICKS;
+	sf::Vector2f offset = packet.position - origin;
+	float distance = vecMagnitude(offset);
+	sf::Vector2f position = distance > reach ? origin + offset * (reach / distance) : packet.position;
+
+	if (bullets.spawn(shooter, position, packet.direction, rewindTicks))
+		client->lastShotTick = tick;
+}
+
+/**
+ * @brief Reads a client's reliable packet, which acks the messages the client received.
+ * @param packet The reliable packet.
+ */
+static void handleReliable(const protocol::Packet& packet)
+{
+	std::lock_guard lock(clientsMutex);
+
+	Client* client = clients.get<CLIENT>(Handle::fromID(packet.index));
+	if (client == nullptr || !client->channel.readPacket(packet.payload))
+		return;
+
+	// clients don't send messages of their own yet, only acks
+	ReliableChannel::Message message;
+	while (client->channel.receive(message)) {}
+}
+
+/**
+ * @brief Counts a discovery reply against the rate limits.
+ * @param source The IP the probe came from.
+ * @return Whether the probe can be answered.
+ */
+static bool allowDiscoveryReply(const std::string& source)
+{
+	std::lock_guard lock(discoveryMutex);
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - discoverySecond >= std::chrono::seconds(1))
 	{
-		lastTimeTimer = now;
-		timerTime = 0;
+		discoverySecond = now;
+		discoveryReplies = 0;
+		discoveryRepliesBySource.clear();
+	}
 
-		timer--;
+	// the total limit is checked first, so the map never grows past it
+	if (discoveryReplies >= DISCOVERY_REPLIES_PER_SECOND)
+		return false;
+
+	int& sourceReplies = discoveryRepliesBySource[source];
+	if (sourceReplies >= DISCOVERY_REPLIES_PER_SOURCE)
+		return false;
+
+	sourceReplies++;
+	discoveryReplies++;
+	return true;
+}
+
+/**
+ * @brief Answers a LAN discovery probe with the server's status.
+ * Probes smaller than the answer, and probes over the rate limits, are ignored.
+ * @param probe The DISCOVER packet.
+ * @param transport The UDP transport.
+ */
+static void answerDiscovery(const protocol::Packet& probe, const sockets::Transport& transport)
+{
+	messages::ServerInfo info;
+	info.name = serverName;
+	info.maxPlayers = numberOfPlayers;
+	info.mazeWidth = globals::MAZE_WIDTH;
+	info.mazeHeight = globals::MAZE_HEIGHT;
+	info.started = gameStarted;
+	{
 		std::lock_guard lock(clientsMutex);
-		broadcast(protocol::keyValueMessage("timer", std::to_string(timer)));
-		if (timer == 0)
-			return true;
+		info.players = clients.size();
+	}
+
+	protocol::Packet packet;
+	packet.type = protocol::PacketType::SERVER_INFO;
+	// the client measures the round trip time with its own timestamp
+	packet.sequence = probe.sequence;
+	packet.payload = messages::encode(info);
+
+	// never send more than the probe, the sender's address could be someone else's
+	std::vector<char> data = protocol::encodePacket(packet);
+	if (protocol::encodePacket(probe).size() < data.size() || !allowDiscoveryReply(probe.address.ip))
+		return;
+
+	try
+	{
+		protocol::sendEncoded(transport, probe.address, data);
+	}
+	catch (sockets::exception& err)
+	{
+		logging::warning("Can't answer discovery", { { "error", err.what() } });
+	}
+}
+
+/**
+ * @brief Answers LAN discovery probes until the game starts, when handleEvents takes over. Runs on its own thread.
+ * @param transport The UDP transport.
+ */
+static void answerDiscoveryInLobby(const sockets::Transport& transport)
+{
+	while (!gameStarted)
+	{
+		protocol::Packet packet = protocol::receivePacket(transport);
+		if (packet.type == protocol::PacketType::DISCOVER)
+			answerDiscovery(packet, transport);
+		else if (packet.type == protocol::PacketType::NO_PACKET)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 	}
-	return false;
 }
 
 /**
  * @brief Receives UDP packets from the clients and handles them according to their type.
- * @param udpSocket The UDP socket.
+ * @param transport The UDP transport.
  */
-static void handleEvents(const sockets::Socket& udpSocket)
+static void handleEvents(const sockets::Transport& transport)
 {
 	protocol::PacketType receivedType = protocol::PacketType::NO_PACKET;
+	int handledPackets = 0;
 
 	// receive until received NO_PACKET
 	do
 	{
-		auto packet = protocol::receivePacket(udpSocket);
+		auto packet = protocol::receivePacket(transport);
 		receivedType = packet.type;
+		if (receivedType != protocol::PacketType::NO_PACKET)
+			handledPackets++;
 
-		if (packet.type == protocol::PacketType::UPDATE_PLAYER)
-		{
-			clients[packet.index].player.pos = packet.position;
+		// packets of a player that didn't come from its client are dropped before they are recorded
+		bool fromPlayer = packet.type == protocol::PacketType::PLAYER_INPUT || packet.type == protocol::PacketType::UPDATE_BULLET
+			|| packet.type == protocol::PacketType::RELIABLE;
+		if (fromPlayer && !isFromClient(packet))
+			continue;
 
-			forEachUDP(
-				[udpSocket, packet](sockets::Address address)
-				{
-					protocol::sendPacket(udpSocket, address, packet);
-				}
-			);
-		}
+		// only the packets that change the simulation are needed to simulate it again
+		bool simulated = packet.type == protocol::PacketType::PLAYER_INPUT || packet.type == protocol::PacketType::UPDATE_BULLET;
+		if (simulated && recorder.isOpen())
+			recorder.write({ .tick = tick, .type = replay::RecordType::PACKET, .data = protocol::encodePacket(packet) });
+
+		if (packet.type == protocol::PacketType::PLAYER_INPUT)
+			handleInput(packet);
+
+		else if (packet.type == protocol::PacketType::RELIABLE)
+			handleReliable(packet);
+
+		else if (packet.type == protocol::PacketType::DISCOVER)
+			answerDiscovery(packet, transport);
 
 		else if (packet.type == protocol::PacketType::UPDATE_BULLET)
-			bullets.push_back({ packet.index, packet.position, { cosf(packet.direction), sinf(packet.direction) } });
+			handleShot(packet);
 
 	}
 	while (receivedType != protocol::PacketType::NO_PACKET);
+
+	serverMetrics.packetsPerTick.set(handledPackets);
+	serverMetrics.receiveQueueBytes.set(transport.available());
+}
+
+/**
+ * @brief Records the positions of all players in this tick.
+ */
+static void recordHistory()
+{
+	std::lock_guard lock(clientsMutex);
+
+	history.beginTick(tick);
+	for (int i = 0; i < clients.size(); i++)
+		history.record(clients.handleAt(i).index, clients.column<PLAYER>()[i].pos);
 }
 
 /**
- * @brief Sends all clients the bullets' information.
- * @param udpSocket The UDP socket.
+ * @brief Returns how much a client needs updates about a player every tick,
+ * according to whether it can see the player, how far it is and whether the player is shooting.
+ * @param viewer The client's position in clients.
+ * @param target The player's position in clients.
+ * @param visibleCells The cells the viewer's cell can see, decoded once per viewer with VisibilityMap::getVisible.
+ * @return The priority, 1 for an update every tick.
  */
-static void sendBullets(const sockets::Socket& udpSocket)
+static float playerPriority(int viewer, int target, const std::vector<bool>& visibleCells)
 {
-	forEachUDP(
-		[udpSocket](sockets::Address address)
+	sf::Vector2f viewerPosition = clients.column<PLAYER>()[viewer].pos;
+	sf::Vector2f targetPosition = clients.column<PLAYER>()[target].pos;
+
+	// the visibility of the cells is checked first, it's much cheaper than walking the line
+	float priority = 1.0f;
+	sf::Vector2i targetCell = { (int)targetPosition.x, (int)targetPosition.y };
+	bool inMaze = targetCell.x >= 0 && targetCell.x < globals::WORLD_WIDTH && targetCell.y >= 0 && targetCell.y < globals::WORLD_HEIGHT;
+	if (!inMaze || !visibleCells[targetCell.y * globals::WORLD_WIDTH + targetCell.x] || !globals::hasLineOfSight(maze, viewerPosition, targetPosition))
+		priority = 1.0f / OCCLUDED_UPDATE_RATE;
+	else if (vecMagnitude(targetPosition - viewerPosition) > NEAR_DISTANCE)
+		priority = 1.0f / FAR_UPDATE_RATE;
+
+	int lastShotTick = clients.column<CLIENT>()[target].lastShotTick;
+	if (lastShotTick >= 0 && tick - lastShotTick < NUMBER_OF_TICKS)
+		priority *= SHOOTER_PRIORITY;
+
+	return priority;
+}
+
+/**
+ * @brief Makes a packet with the simulated position of a player and its last input.
+ * @param target The player's position in clients.
+ * @return The packet.
+ */
+static protocol::Packet playerPacket(int target)
+{
+	const Player& player = clients.column<PLAYER>()[target];
+
+	protocol::Packet packet;
+	packet.type = protocol::PacketType::UPDATE_PLAYER;
+	packet.index = clients.handleAt(target).toID();
+	packet.position = player.pos;
+	packet.direction = player.direction;
+	packet.sequence = clients.column<CLIENT>()[target].lastInput;
+	packet.tick = tick;
+	return packet;
+}
+
+/**
+ * @brief Sends every client the simulated positions of the players, as much as its send budget allows.
+ * Every player adds its priority to an accumulator every tick, and the players with the highest accumulators are sent first.
+ * A player isn't sent before its accumulator reaches 1, so with enough budget hidden and far players are sent less often,
+ * and with too little budget the least important players wait longer.
+ * @param transport The UDP transport.
+ */
+static void sendPlayers(const sockets::Transport& transport)
+{
+	std::lock_guard lock(clientsMutex);
+
+	// a player's packet is the same for every viewer, so it's encoded once
+	std::vector<std::vector<char>> encoded;
+	for (int target = 0; target < clients.size(); target++)
+		encoded.push_back(protocol::encodePacket(playerPacket(target)));
+
+	std::vector<bool> visibleCells;
+
+	for (int viewer = 0; viewer < clients.size(); viewer++)
+	{
+		Client& client = clients.column<CLIENT>()[viewer];
+		client.budget.update(1.0f / NUMBER_OF_TICKS, client.channel.getStats());
+		client.priorities.resize(Handle::MAX_INDEX + 1, 0.0f);
+
+		// the client's own player is needed every tick for reconciliation
+		client.budget.spend(protocol::sendEncoded(transport, client.udpAddress, encoded[viewer]));
+
+		// decoded once, and looked up for every player
+		sf::Vector2f viewerPosition = clients.column<PLAYER>()[viewer].pos;
+		visibility.getVisible({ (int)viewerPosition.x, (int)viewerPosition.y }, visibleCells);
+
+		// (accumulated priority, player)
+		std::vector<std::pair<float, int>> candidates;
+		for (int target = 0; target < clients.size(); target++)
 		{
-			// clear the bullets
-			protocol::Packet packet;
-			packet.type = protocol::PacketType::CLEAR_BULLETS;
-			protocol::sendPacket(udpSocket, address, packet);
+			if (target == viewer)
+				continue;
 
-			packet.type = protocol::PacketType::UPDATE_BULLET;
+			float& priority = client.priorities[clients.handleAt(target).index];
+			priority += playerPriority(viewer, target, visibleCells);
+			if (priority >= 1.0f)
+				candidates.push_back({ priority, target });
+		}
 
-			// send new bullet information
-			for (int i = 0; i < bullets.size(); i++)
-			{
-				packet.index = (char)i;
-				packet.position = bullets[i].position;
+		std::sort(candidates.begin(), candidates.end(), std::greater<>());
 
-				protocol::sendPacket(udpSocket, address, packet);
-			}
+		for (auto [priority, target] : candidates)
+		{
+			if (!client.budget.canSend((int)encoded[target].size()))
+				break;
+
+			client.budget.spend(protocol::sendEncoded(transport, client.udpAddress, encoded[target]));
+			client.priorities[clients.handleAt(target).index] = 0;
+		}
+	}
+}
+
+/**
+ * @brief Sends every client the bullets it can see.
+ * The bullets are sent all together, so if the send budget is too small they are skipped for this tick
+ * (the client keeps moving them), but not for more than MAX_BULLETS_DELAY ticks.
+ * @param transport The UDP transport.
+ */
+static void sendBullets(const sockets::Transport& transport)
+{
+	std::lock_guard lock(clientsMutex);
+
+	std::vector<int> visible;
+	std::vector<bool> visibleCells;
+
+	for (int viewer = 0; viewer < clients.size(); viewer++)
+	{
+		Client& client = clients.column<CLIENT>()[viewer];
+		sf::Vector2f viewerPosition = clients.column<PLAYER>()[viewer].pos;
+
+		// bullets in cells the viewer's cell can't see are skipped without walking the line
+		visibility.getVisible({ (int)viewerPosition.x, (int)viewerPosition.y }, visibleCells);
+
+		visible.clear();
+		for (int i = 0; i < bullets.size(); i++)
+		{
+			sf::Vector2i cell = { (int)bullets.position(i).x, (int)bullets.position(i).y };
+			bool inMaze = cell.x >= 0 && cell.x < globals::WORLD_WIDTH && cell.y >= 0 && cell.y < globals::WORLD_HEIGHT;
+			if (inMaze && !visibleCells[cell.y * globals::WORLD_WIDTH + cell.x])
+				continue;
+
+			if (globals::hasLineOfSight(maze, viewerPosition, bullets.position(i)))
+				visible.push_back(i);
 		}
-	);
+
+		protocol::Packet packet;
+		packet.type = protocol::PacketType::CLEAR_BULLETS;
+		packet.tick = tick;
+
+		// every bullet packet is about the size of the first one
+		int size = (int)protocol::encodePacket(packet).size();
+		if (!visible.empty())
+		{
+			protocol::Packet bulletPacket = packet;
+			bulletPacket.type = protocol::PacketType::UPDATE_BULLET;
+			bulletPacket.index = bullets.handleAt(visible[0]).toID();
+			bulletPacket.position = bullets.position(visible[0]);
+			size += (int)visible.size() * ((int)protocol::encodePacket(bulletPacket).size() + SendBudget::PACKET_OVERHEAD);
+		}
+
+		if (!client.budget.canSend(size) && tick - client.lastBulletsTick < MAX_BULLETS_DELAY)
+			continue;
+		client.lastBulletsTick = tick;
+
+		// clear the bullets
+		client.budget.spend(protocol::sendPacket(transport, client.udpAddress, packet));
+
+		packet.type = protocol::PacketType::UPDATE_BULLET;
+
+		// send new bullet information
+		for (int i : visible)
+		{
+			packet.index = bullets.handleAt(i).toID();
+			packet.position = bullets.position(i);
+
+			client.budget.spend(protocol::sendPacket(transport, client.udpAddress, packet));
+		}
+	}
+}
+
+/**
+ * @brief Publishes the positions of all the players and all the bullets to the spectators.
+ * The hub sends them from its own thread, so the tick costs the same for any number of spectators.
+ */
+static void publishSnapshot()
+{
+	if (spectators.getViewerCount() == 0)
+		return;
+
+	std::lock_guard lock(clientsMutex);
+
+	for (int i = 0; i < clients.size(); i++)
+		spectators.publish(playerPacket(i));
+
+	protocol::Packet packet;
+	packet.type = protocol::PacketType::CLEAR_BULLETS;
+	packet.tick = tick;
+	spectators.publish(packet);
+
+	packet.type = protocol::PacketType::UPDATE_BULLET;
+	for (int i = 0; i < bullets.size(); i++)
+	{
+		packet.index = bullets.handleAt(i).toID();
+		packet.position = bullets.position(i);
+		spectators.publish(packet);
+	}
+}
+
+/**
+ * @brief Sends every client a packet with its waiting reliable messages and acks, if it has any.
+ * @param transport The UDP transport.
+ */
+static void sendReliable(const sockets::Transport& transport)
+{
+	std::lock_guard lock(clientsMutex);
+
+	for (int i = 0; i < clients.size(); i++)
+	{
+		Client& client = clients.column<CLIENT>()[i];
+
+		protocol::Packet packet;
+		packet.payload = client.channel.writePacket();
+		if (packet.payload.empty())
+			continue;
+
+		packet.type = protocol::PacketType::RELIABLE;
+		packet.index = clients.handleAt(i).toID();
+		packet.tick = tick;
+		client.budget.spend(protocol::sendPacket(transport, client.udpAddress, packet));
+	}
+
+	for (int i = 0; i < clients.size(); i++)
+	{
+		if (metrics::ClientMetrics* clientMetrics = serverMetrics.client(clients.handleAt(i).index))
+		{
+			const ReliableChannel::Stats& stats = clients.column<CLIENT>()[i].channel.getStats();
+			clientMetrics->connected = true;
+			clientMetrics->rtt.set(stats.rtt);
+			clientMetrics->jitter.set(stats.jitter);
+			clientMetrics->loss.set(stats.loss);
+			clientMetrics->sendRate.set(clients.column<CLIENT>()[i].budget.getRate());
+		}
+	}
 }
 
 /**
@@ -358,26 +942,206 @@ static void sendBullets(const sockets::Socket& udpSocket)
  */
 static void sendWin()
 {
+	std::lock_guard lock(clientsMutex);
+
 	std::string wonPlayers;
 	int maxScore = 0;
 
-	for (auto& [index, client] : clients)
-		maxScore = max(client.score, maxScore);
+	for (int score : clients.column<SCORE>())
+		maxScore = max(score, maxScore);
 
-	for (auto& [index, client] : clients)
+	for (int i = 0; i < clients.size(); i++)
 	{
-		if (client.score == maxScore)
+		if (clients.column<SCORE>()[i] == maxScore)
 		{
+			const std::string& name = clients.column<CLIENT>()[i].name;
 			if (wonPlayers == "")
-				wonPlayers = client.name;
+				wonPlayers = name;
 			else
-				wonPlayers += " +\n" + client.name;
+				wonPlayers += " +\n" + name;
 		}
 	}
 
 	wonPlayers += "\nwon!";
 
-	broadcast(protocol::keyValueMessage("end", wonPlayers));
+	broadcastReliable(messages::End{ wonPlayers });
+}
+
+/**
+ * @brief Hashes the state of the simulation (FNV-1a), to check that a replay simulates the same match.
+ * @return The hash.
+ */
+static uint32_t stateChecksum()
+{
+	std::lock_guard lock(clientsMutex);
+
+	uint32_t hash = 2166136261u;
+	auto add = [&hash](uint32_t value)
+	{
+		hash = (hash ^ value) * 16777619u;
+	};
+
+	for (int i = 0; i < clients.size(); i++)
+	{
+		const Player& player = clients.column<PLAYER>()[i];
+		add(clients.handleAt(i).toID());
+		add(std::bit_cast<uint32_t>(player.pos.x));
+		add(std::bit_cast<uint32_t>(player.pos.y));
+		add(player.lives);
+		add(clients.column<SCORE>()[i]);
+	}
+
+	for (int i = 0; i < bullets.size(); i++)
+	{
+		add(bullets.handleAt(i).toID());
+		add(std::bit_cast<uint32_t>(bullets.position(i).x));
+		add(std::bit_cast<uint32_t>(bullets.position(i).y));
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Runs one tick of the game.
+ * @param transport The UDP transport.
+ * @param secondPassed Whether a second of the game timer passed.
+ */
+static void runTick(const sockets::Transport& transport, bool secondPassed)
+{
+	auto tickStart = std::chrono::steady_clock::now();
+	bool finished = false;
+	if (secondPassed)
+	{
+		metrics::Timer timer(serverMetrics.sendTimerUpdateSeconds);
+		finished = sendTimerUpdate();
+	}
+
+	if (finished)
+		sendWin();
+	else
+	{
+		{
+			metrics::Timer timer(serverMetrics.handleEventsSeconds);
+			handleEvents(transport);
+		}
+		recordHistory();
+		{
+			metrics::Timer timer(serverMetrics.sendPlayersSeconds);
+			sendPlayers(transport);
+		}
+		{
+			metrics::Timer timer(serverMetrics.updateBulletsSeconds);
+			updateBullets(transport);
+		}
+		{
+			metrics::Timer timer(serverMetrics.sendBulletsSeconds);
+			sendBullets(transport);
+		}
+		publishSnapshot();
+	}
+
+	// all the messages of this tick in one packet per client
+	sendReliable(transport);
+
+	if (recorder.isOpen() && tick % CHECKSUM_INTERVAL == 0)
+		recorder.write({ .tick = tick, .type = replay::RecordType::CHECKSUM, .checksum = stateChecksum() });
+
+	serverMetrics.activeBullets.set(bullets.size());
+	serverMetrics.connectedClients.set(count);
+
+	std::chrono::duration<double> tickDuration = std::chrono::steady_clock::now() - tickStart;
+	serverMetrics.tickSeconds.observe(tickDuration.count());
+	if (tickDuration.count() > 1.0 / NUMBER_OF_TICKS)
+		serverMetrics.tickOverruns.add();
+}
+
+/**
+ * @brief Simulates a recorded match again, as fast as possible, without clients.
+ * The recorded packets are sent to the server over a loopback network without delay,
+ * so every tick receives the packets that were received in it during the match.
+ * @param path The path of the replay file.
+ */
+static void runReplay(const std::string& path)
+{
+	replay::Reader reader;
+	if (!reader.open(path))
+	{
+		logging::error("Can't read replay", { { "path", path } });
+		return;
+	}
+
+	numberOfPlayers = reader.getNumberOfPlayers();
+	seedRandom(reader.getSeed());
+	maze = globals::generateMaze();
+	visibility.compute(maze);
+	history = PositionHistory(numberOfPlayers);
+	serverMetrics.setMaxClients(numberOfPlayers);
+
+	sockets::LoopbackNetwork network;
+	sockets::LoopbackTransport transport(network, { "0.0.0.0", globals::UDP_PORT });
+	sockets::LoopbackTransport clientTransport(network, { "127.0.0.1", 0 });
+
+	int mismatches = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	replay::Record record;
+	bool hasRecord = reader.next(record);
+
+	// applies the records of the current tick, except for checksums which are checked after the tick
+	auto applyRecords = [&](bool& secondPassed)
+	{
+		for (; hasRecord && record.tick <= tick && record.type != replay::RecordType::CHECKSUM; hasRecord = reader.next(record))
+		{
+			std::lock_guard lock(clientsMutex);
+
+			if (record.type == replay::RecordType::JOIN)
+			{
+				count++;
+				Handle handle = addPlayer(record.name, sockets::Socket(), record.position);
+				if (handle.toID() != record.id)
+					logging::warning("Replay player got a different ID", { { "tick", std::to_string(tick) }, { "name", record.name } });
+
+				// only packets that came from the players were recorded, and they are all sent again from one address
+				clients.get<CLIENT>(handle)->udpAddress = clientTransport.getSocketName();
+			}
+			else if (record.type == replay::RecordType::LEAVE)
+				removePlayer(Handle::fromID(record.id));
+			else if (record.type == replay::RecordType::PACKET)
+				clientTransport.sendTo(record.data, transport.getSocketName());
+			else if (record.type == replay::RecordType::TIMER)
+				secondPassed = true;
+		}
+	};
+
+	// the players joined before the game started
+	bool secondPassed = false;
+	applyRecords(secondPassed);
+	spawnPlayers();
+
+	while (hasRecord)
+	{
+		tick++;
+
+		secondPassed = false;
+		applyRecords(secondPassed);
+		runTick(transport, secondPassed);
+
+		for (; hasRecord && record.tick <= tick && record.type == replay::RecordType::CHECKSUM; hasRecord = reader.next(record))
+		{
+			if (stateChecksum() != record.checksum && mismatches++ == 0)
+				logging::warning("Replay differs from the recorded match", { { "tick", std::to_string(tick) } });
+		}
+	}
+
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	double matchSeconds = (double)tick / NUMBER_OF_TICKS;
+	logging::info("Replay finished", {
+		{ "ticks", std::to_string(tick) },
+		{ "seconds", std::to_string(duration.count()) },
+		{ "speedup", std::to_string(matchSeconds / max(duration.count(), 1e-9)) },
+		{ "mismatches", std::to_string(mismatches) },
+		{ "checksum", std::to_string(stateChecksum()) }
+	});
 }
 
 /**
@@ -401,13 +1165,73 @@ static bool parseNumberOfPlayers(const std::string& input)
 	return true;
 }
 
+/**
+ * @brief Parses the port to serve metrics on.
+ * @param input The input string.
+ * @param port Set to the port, 0 for no metrics.
+ * @return Whether the input is a valid port.
+ */
+static bool parseMetricsPort(const std::string& input, unsigned short& port)
+{
+	try
+	{
+		int inputInt = std::stoi(input);
+		if (inputInt < 0 || inputInt > 65535)
+			return false;
+		port = (unsigned short)inputInt;
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+	return true;
+}
+
 /**
  * @brief The main function.
+ * @param argc The number of arguments.
+ * @param argv The arguments, "--replay <path>" simulates a recorded match instead of hosting one,
+ * "--relay <server IP> [delay] [token]" relays the match of a server to spectators,
+ * and "--metrics-port <port>" hosts a match with the metrics on another port (0 turns them off).
  */
-void main()
+void main(int argc, char* argv[])
 {
 	sockets::initialize();
 
+	if (argc == 3 && std::string(argv[1]) == "--replay")
+	{
+		logging::start(logging::Level::INFO);
+		runReplay(argv[2]);
+		logging::stop();
+		sockets::shutdown();
+		return;
+	}
+
+	if (argc >= 3 && argc <= 5 && std::string(argv[1]) == "--relay")
+	{
+		logging::start(logging::Level::INFO, "relay-log.jsonl");
+		try
+		{
+			Relay relay(argc >= 4 ? std::stod(argv[3]) : Relay::DEFAULT_DELAY, argc == 5 ? argv[4] : "");
+			relay.run(argv[2]);
+		}
+		catch (std::exception& err)
+		{
+			logging::error("Relay error", { { "error", err.what() } });
+		}
+		logging::stop();
+		sockets::shutdown();
+		return;
+	}
+
+	unsigned short metricsPort = DEFAULT_METRICS_PORT;
+	if (argc == 3 && std::string(argv[1]) == "--metrics-port" && !parseMetricsPort(argv[2], metricsPort))
+	{
+		std::cout << "Invalid metrics port." << std::endl;
+		sockets::shutdown();
+		return;
+	}
+
 	std::string input;
 
 	std::cout << "Enter number of players: ";
@@ -420,11 +1244,37 @@ void main()
 		std::cin >> input;
 	}
 
+	// structured logs are also kept in a file, one JSON object per line
+	logging::start(logging::Level::INFO, "server-log.jsonl");
+
+	char hostName[256] = {};
+	serverName = gethostname(hostName, sizeof(hostName)) == 0 ? hostName : "Chaos Corridors";
+	serverName = serverName.substr(0, protocol::MAX_SERVER_NAME);
+
+	// the maze is generated from a known seed, so a replay can generate it again
+	unsigned int seed = std::random_device{}();
+	seedRandom(seed);
 	maze = globals::generateMaze();
+	visibility.compute(maze);
+	logging::info("Computed visibility", { { "bytes", std::to_string(visibility.getEncodedSize()) } });
+
+	std::string replayPath = "match-" + std::to_string(std::time(nullptr)) + ".replay";
+	if (recorder.open(replayPath, seed, numberOfPlayers))
+		logging::info("Recording replay", { { "path", replayPath } });
+	else
+		logging::warning("Can't record replay", { { "path", replayPath } });
+
+	// players reuse the slots of players that left, so there are at most numberOfPlayers indices
+	history = PositionHistory(numberOfPlayers);
+	serverMetrics.setMaxClients(numberOfPlayers);
 
 	sockets::Socket serverSocket(sockets::Protocol::TCP);
 	sockets::Socket udpSocket(sockets::Protocol::UDP);
 	udpSocket.setBlocking(false);
+	sockets::UdpTransport transport(udpSocket);
+
+	metrics::Exporter exporter(serverMetrics);
+	std::thread discoveryThread;
 
 	try
 	{
@@ -432,14 +1282,36 @@ void main()
 		serverSocket.bind({ "0.0.0.0", globals::TCP_PORT });
 		serverSocket.listen(numberOfPlayers);
 
-		std::cout << "Waiting for connections..." << std::endl;
+		// 8 hex digits, short enough to type in the client's name field
+		char spectatorToken[9];
+		snprintf(spectatorToken, sizeof(spectatorToken), "%08x", (unsigned int)std::random_device{}());
+		spectators.start({ "0.0.0.0", globals::SPECTATOR_PORT }, spectatorToken);
+		logging::info("Spectator token", { { "token", spectatorToken } });
+
+		// the metrics are optional, the game goes on without them
+		if (metricsPort != 0)
+		{
+			try
+			{
+				exporter.start({ "127.0.0.1", metricsPort });
+				logging::info("Metrics at http://127.0.0.1:" + std::to_string(metricsPort) + "/metrics");
+			}
+			catch (sockets::exception& err)
+			{
+				logging::warning("Can't serve metrics", { { "port", std::to_string(metricsPort) }, { "error", err.what() } });
+			}
+		}
+
+		logging::info("Waiting for connections...");
+
+		discoveryThread = std::thread(answerDiscoveryInLobby, std::cref(transport));
 
 		while (count < numberOfPlayers)
 		{
 			auto [clientSocket, clientAddress] = serverSocket.accept();
 			clientSocket.setTimeout(0);
 			clientThreads.push_back(std::thread(handleClient, clientSocket, clientAddress));
-			std::cout << "New connection at " << clientAddress.ip << ":" << clientAddress.port << std::endl;
+			logging::info("New connection", { { "address", clientAddress.ip + ":" + std::to_string(clientAddress.port) } });
 			count++;
 		}
 
@@ -450,10 +1322,15 @@ void main()
 		while (clients.size() != numberOfPlayers) {}
 
 		std::this_thread::sleep_for(std::chrono::milliseconds(500));
-		broadcast(protocol::keyValueMessage("soon", ""));
+		broadcast(messages::Soon{});
+		spectators.soon();
 
 		std::this_thread::sleep_for(std::chrono::seconds(SECONDS_BEFORE_START));
-		initGame(udpSocket);
+
+		// the game loop answers discovery from now on
+		gameStarted = true;
+		discoveryThread.join();
+		initGame(transport);
 
 		// to do the loop 60 times per second
 		int elapsedTime = 0;
@@ -470,26 +1347,28 @@ void main()
 			if (!checkDelay(elapsedTime, lastTimeTick, now))
 				continue;
 
-			bool finished = sendTimerUpdate(timerTime, lastTimeTimer, now);
-			if (finished)
-				sendWin();
-			else
-			{
-				handleEvents(udpSocket);
-				updateBullets(udpSocket);
-				sendBullets(udpSocket);
-			}
+			tick++;
+
+			runTick(transport, checkSecond(timerTime, lastTimeTimer, now));
 		}
 
 		for (auto& thread : clientThreads)
 			thread.join();
 
-		std::cout << "Game ended!" << std::endl;
+		logging::info("Game ended!");
 	}
 	catch (sockets::exception& err)
 	{
-		std::cout << "Server error: " << err.what() << std::endl;
+		logging::error("Server error", { { "error", err.what() } });
 	}
 
+	gameStarted = true;
+	if (discoveryThread.joinable())
+		discoveryThread.join();
+
+	recorder.close();
+	spectators.stop();
+	exporter.stop();
+	logging::stop();
 	sockets::shutdown();
 }
@@ -0,0 +1,249 @@
+#include "connector.hpp"
+#include <thread>
+
+namespace sockets
+{
+	/**
+	 * @brief Checks if a host is an IP, which doesn't need a lookup.
+	 * @param host The host.
+	 * @return Whether the host is an IPv4 or IPv6 address.
+	 */
+	static bool isIp(const std::string& host)
+	{
+		in6_addr buffer{};
+		return inet_pton(AF_INET, host.c_str(), &buffer) == 1 || inet_pton(AF_INET6, host.c_str(), &buffer) == 1;
+	}
+
+	Connector::Connector() : state(State::IDLE), nextAddress(0) { }
+
+	Connector::~Connector()
+	{
+		cancel();
+	}
+
+	void Connector::start(const std::string& host, unsigned short port, float timeoutSeconds)
+	{
+		cancel();
+
+		deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(timeoutSeconds));
+		error = "";
+		state = State::RESOLVING;
+
+		resolution = std::make_shared<Resolution>();
+		if (isIp(host))
+		{
+			resolution->addresses = { { host, port } };
+			resolution->done = true;
+			return;
+		}
+
+		// a lookup can't be cancelled, so the thread only holds the result and is left to finish on its own
+		std::thread([resolution = resolution, host, port]()
+		{
+			std::vector<Address> addresses;
+			std::string error;
+			try
+			{
+				addresses = resolve(host, port);
+			}
+			catch (exception& err)
+			{
+				error = err.what();
+			}
+
+			std::lock_guard lock(resolution->mutex);
+			resolution->addresses = std::move(addresses);
+			resolution->error = std::move(error);
+			resolution->done = true;
+		}).detach();
+	}
+
+	Connector::State Connector::poll()
+	{
+		if (state != State::RESOLVING && state != State::CONNECTING)
+			return state;
+
+		clock::time_point now = clock::now();
+		if (now >= deadline)
+		{
+			fail(state == State::RESOLVING ? "Resolving the host timed out" : "Socket timed out");
+			return state;
+		}
+
+		if (state == State::RESOLVING)
+			checkResolution();
+
+		if (state == State::CONNECTING)
+		{
+			checkAttempts();
+
+			// the next address starts when the last attempt is slow or there are no attempts left
+			if (state == State::CONNECTING && (attempts.empty() || now - lastAttempt >= std::chrono::duration<float>(ATTEMPT_DELAY)))
+				startNextAttempt(now);
+
+			if (state == State::CONNECTING && attempts.empty() && nextAddress == addresses.size())
+				fail(error.empty() ? "Can't connect to any address" : error);
+		}
+
+		return state;
+	}
+
+	void Connector::cancel()
+	{
+		closeAttempts();
+		resolution.reset();
+		addresses.clear();
+		nextAddress = 0;
+		state = State::IDLE;
+	}
+
+	Connector::State Connector::getState() const
+	{
+		return state;
+	}
+
+	Socket Connector::getSocket() const
+	{
+		return socket;
+	}
+
+	Address Connector::getAddress() const
+	{
+		return address;
+	}
+
+	const std::string& Connector::getError() const
+	{
+		return error;
+	}
+
+	void Connector::checkResolution()
+	{
+		std::lock_guard lock(resolution->mutex);
+		if (!resolution->done)
+			return;
+
+		if (resolution->addresses.empty())
+		{
+			std::string resolveError = resolution->error.empty() ? "The host has no addresses" : resolution->error;
+			fail(resolveError);
+			return;
+		}
+
+		addresses = resolution->addresses;
+		nextAddress = 0;
+		state = State::CONNECTING;
+	}
+
+	void Connector::startNextAttempt(clock::time_point now)
+	{
+		while (nextAddress < addresses.size())
+		{
+			Address next = addresses[nextAddress++];
+			Socket attemptSocket;
+			try
+			{
+				attemptSocket = Socket(Protocol::TCP, next.getFamily());
+			}
+			catch (exception& err)
+			{
+				// this family isn't available here
+				error = err.what();
+				continue;
+			}
+
+			try
+			{
+				attemptSocket.setBlocking(false);
+				attemptSocket.startConnect(next);
+			}
+			catch (exception& err)
+			{
+				error = err.what();
+				attemptSocket.close();
+				continue;
+			}
+
+			attempts.push_back({ attemptSocket, next });
+			lastAttempt = now;
+			return;
+		}
+	}
+
+	void Connector::checkAttempts()
+	{
+		if (attempts.empty())
+			return;
+
+		// a connected socket is writable, a failed one is in exceptfds (Windows) or writable with an error
+		fd_set writefds{}, exceptfds{};
+		FD_ZERO(&writefds);
+		FD_ZERO(&exceptfds);
+		SOCKET maxId = 0;
+		for (const Attempt& attempt : attempts)
+		{
+			FD_SET(attempt.socket.getID(), &writefds);
+			FD_SET(attempt.socket.getID(), &exceptfds);
+			if (attempt.socket.getID() > maxId)
+				maxId = attempt.socket.getID();
+		}
+
+		timeval tv{};
+		int result = select((int)maxId + 1, NULL, &writefds, &exceptfds, &tv);
+		if (result <= 0)
+			return;
+
+		for (size_t i = 0; i < attempts.size();)
+		{
+			SOCKET id = attempts[i].socket.getID();
+			if (!FD_ISSET(id, &writefds) && !FD_ISSET(id, &exceptfds))
+			{
+				i++;
+				continue;
+			}
+
+			int so_error{};
+			socklen_t len = sizeof(so_error);
+			getsockopt(id, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
+
+			if (so_error == 0 && FD_ISSET(id, &writefds))
+			{
+				socket = attempts[i].socket;
+				address = attempts[i].address;
+				socket.setBlocking(true);
+
+				// the others lost the race
+				attempts.erase(attempts.begin() + i);
+				closeAttempts();
+				error = "";
+				state = State::CONNECTED;
+				return;
+			}
+
+			error = exception(so_error).what();
+			attempts[i].socket.close();
+			attempts.erase(attempts.begin() + i);
+		}
+	}
+
+	void Connector::closeAttempts()
+	{
+		for (Attempt& attempt : attempts)
+		{
+			try
+			{
+				attempt.socket.close();
+			}
+			catch (exception&) {}
+		}
+		attempts.clear();
+	}
+
+	void Connector::fail(const std::string& error)
+	{
+		closeAttempts();
+		resolution.reset();
+		this->error = error;
+		state = State::FAILED;
+	}
+}
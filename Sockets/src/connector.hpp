@@ -0,0 +1,154 @@
+/**
+* Connecting without blocking: a TCP connection to a host that is polled from a loop until it connects.
+*/
+#pragma once
+
+#include "sockets.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace sockets
+{
+	/**
+	 * @brief Connects a TCP socket to a host without blocking the thread that uses it.
+	 * The host is resolved on a background thread (unless it's an IP), and its addresses are tried like happy eyeballs (RFC 8305):
+	 * a new attempt starts every ATTEMPT_DELAY (or as soon as the previous one fails) while the earlier ones keep going,
+	 * and the first one that connects wins.
+	 * Call poll every frame until the state is CONNECTED or FAILED.
+	 */
+	class Connector
+	{
+	public:
+		/**
+		 * @brief The state of the connection.
+		 */
+		enum class State
+		{
+			IDLE,		// not started, or cancelled
+			RESOLVING,	// waiting for the addresses of the host
+			CONNECTING,	// trying the addresses
+			CONNECTED,	// getSocket returns the connected socket
+			FAILED		// getError says why
+		};
+
+		// how many seconds an attempt gets before the next address is tried alongside it (the RFC recommends 250ms)
+		inline static const float ATTEMPT_DELAY = 0.25f;
+
+		/**
+		 * @brief Creates a new Connector object in the IDLE state.
+		 */
+		Connector();
+
+		/**
+		 * @brief Cancels the connection if it didn't finish.
+		 */
+		~Connector();
+
+		Connector(const Connector&) = delete;
+		Connector& operator=(const Connector&) = delete;
+
+		/**
+		 * @brief Starts connecting. Cancels the previous connection if it didn't finish.
+		 * @param host The host name or IP.
+		 * @param port The port.
+		 * @param timeoutSeconds How many seconds until the connection fails, including resolving the host.
+		 */
+		void start(const std::string& host, unsigned short port, float timeoutSeconds);
+
+		/**
+		 * @brief Advances the connection without blocking: checks the attempts and starts new ones when they are due.
+		 * @return The state after advancing.
+		 */
+		State poll();
+
+		/**
+		 * @brief Stops connecting and closes the sockets of the attempts. Goes back to IDLE.
+		 * A socket that already connected isn't closed, it belongs to the caller.
+		 */
+		void cancel();
+
+		/**
+		 * @brief Returns the state.
+		 * @return The state.
+		 */
+		State getState() const;
+
+		/**
+		 * @brief Returns the connected socket, in blocking mode. The caller owns it and closes it.
+		 * @return The socket, valid after the state became CONNECTED.
+		 */
+		Socket getSocket() const;
+
+		/**
+		 * @brief Returns the address the socket connected to.
+		 * @return The address, valid after the state became CONNECTED.
+		 */
+		Address getAddress() const;
+
+		/**
+		 * @brief Returns why the connection failed.
+		 * @return The error, valid when the state is FAILED.
+		 */
+		const std::string& getError() const;
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		// the result of resolving the host, shared with the resolving thread so it can finish after a cancel
+		struct Resolution
+		{
+			std::mutex mutex;
+			bool done = false;
+			std::vector<Address> addresses;
+			std::string error;
+		};
+
+		struct Attempt
+		{
+			Socket socket;
+			Address address;
+		};
+
+		/**
+		 * @brief Takes the addresses of the host once they are resolved.
+		 */
+		void checkResolution();
+
+		/**
+		 * @brief Starts connecting to the next address. Addresses that fail right away are skipped.
+		 * @param now The current time.
+		 */
+		void startNextAttempt(clock::time_point now);
+
+		/**
+		 * @brief Checks which attempts connected or failed, without waiting.
+		 */
+		void checkAttempts();
+
+		/**
+		 * @brief Closes the sockets of all the attempts (except the one that connected).
+		 */
+		void closeAttempts();
+
+		/**
+		 * @brief Fails the connection.
+		 * @param error Why it failed.
+		 */
+		void fail(const std::string& error);
+
+		State state;
+		clock::time_point deadline;
+
+		std::shared_ptr<Resolution> resolution;
+		std::vector<Address> addresses;
+		size_t nextAddress;
+
+		std::vector<Attempt> attempts;
+		clock::time_point lastAttempt;
+
+		Socket socket;
+		Address address;
+		std::string error;
+	};
+}
@@ -5,38 +5,70 @@
 
 namespace sockets
 {
-	static sockaddr_in addressToRawAddress(Address address)
+	/**
+	 * @brief An address in the form the socket functions take, for both families.
+	 */
+	struct RawAddress
+	{
+		sockaddr_storage storage{};
+		int length = 0;
+
+		sockaddr* get() { return (sockaddr*)&storage; }
+	};
+
+	static RawAddress addressToRawAddress(Address address)
 	{
 		int result;
+		RawAddress rawAddress;
+
 		// getting ip from string
-		unsigned long ip = 0;
-		
-		result = inet_pton(AF_INET, address.ip.c_str(), &ip);
+		if (address.getFamily() == AddressFamily::IPV6)
+		{
+			sockaddr_in6* raw = (sockaddr_in6*)&rawAddress.storage;
+			result = inet_pton(AF_INET6, address.ip.c_str(), &raw->sin6_addr);
+			raw->sin6_family = AF_INET6;
+			raw->sin6_port = htons(address.port);
+			rawAddress.length = sizeof(sockaddr_in6);
+		}
+		else
+		{
+			sockaddr_in* raw = (sockaddr_in*)&rawAddress.storage;
+			result = inet_pton(AF_INET, address.ip.c_str(), &raw->sin_addr);
+			raw->sin_family = AF_INET;
+			raw->sin_port = htons(address.port);
+			rawAddress.length = sizeof(sockaddr_in);
+		}
+
 		if (result == -1)
 			throw exception(WSAGetLastError());
 		if (result == 0)
 			throw exception("Invalid IP.");
 
-		// setting up the address
-		sockaddr_in rawAddress{};
-		rawAddress.sin_family = AF_INET;
-		rawAddress.sin_port = htons(address.port);
-		rawAddress.sin_addr.s_addr = ip;
-
 		return rawAddress;
 	}
-	static Address rawAddressToAddress(sockaddr_in rawAddress)
+	static Address rawAddressToAddress(const sockaddr_storage& rawAddress)
 	{
-		char ipBuffer[16];
+		char ipBuffer[INET6_ADDRSTRLEN];
+		PCSTR result = NULL;
+		unsigned short port = 0;
+
+		if (rawAddress.ss_family == AF_INET6)
+		{
+			const sockaddr_in6* raw = (const sockaddr_in6*)&rawAddress;
+			result = inet_ntop(AF_INET6, &raw->sin6_addr, ipBuffer, sizeof(ipBuffer));
+			port = ntohs(raw->sin6_port);
+		}
+		else
+		{
+			const sockaddr_in* raw = (const sockaddr_in*)&rawAddress;
+			result = inet_ntop(AF_INET, &raw->sin_addr, ipBuffer, sizeof(ipBuffer));
+			port = ntohs(raw->sin_port);
+		}
 
-		PCSTR result = inet_ntop(AF_INET, &rawAddress.sin_addr.s_addr, ipBuffer, 16);
 		if (result == NULL)
 			throw exception(WSAGetLastError());
 
-		std::string ip = ipBuffer;
-		unsigned short port = ntohs(rawAddress.sin_port);
-
-		Address resultAddr = { ip, port };
+		Address resultAddr = { ipBuffer, port };
 		return resultAddr;
 	}
 
@@ -75,6 +107,11 @@ namespace sockets
 		return errorCode;
 	}
 
+	AddressFamily Address::getFamily() const
+	{
+		return ip.find(':') != std::string::npos ? AddressFamily::IPV6 : AddressFamily::IPV4;
+	}
+
 	bool operator ==(const sockets::Address& addr1, const sockets::Address& addr2)
 	{
 		return addr1.port == addr2.port && addr1.ip == addr2.ip;
@@ -85,6 +122,46 @@ namespace sockets
 		return sock1.getID() == sock2.getID();
 	}
 
+	std::vector<Address> resolve(const std::string& host, unsigned short port)
+	{
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+
+		addrinfo* results = nullptr;
+		int result = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &results);
+		if (result != 0)
+			throw exception(result);
+
+		// the system's order, split by family
+		std::vector<Address> ipv4, ipv6;
+		AddressFamily preferred = results->ai_family == AF_INET6 ? AddressFamily::IPV6 : AddressFamily::IPV4;
+		for (addrinfo* info = results; info != nullptr; info = info->ai_next)
+		{
+			if (info->ai_family != AF_INET && info->ai_family != AF_INET6)
+				continue;
+
+			sockaddr_storage storage{};
+			memcpy(&storage, info->ai_addr, info->ai_addrlen);
+			(info->ai_family == AF_INET6 ? ipv6 : ipv4).push_back(rawAddressToAddress(storage));
+		}
+		freeaddrinfo(results);
+
+		// alternate the families, so a family that doesn't work only delays the first attempt
+		std::vector<Address>& first = preferred == AddressFamily::IPV6 ? ipv6 : ipv4;
+		std::vector<Address>& second = preferred == AddressFamily::IPV6 ? ipv4 : ipv6;
+		std::vector<Address> addresses;
+		for (size_t i = 0; i < first.size() || i < second.size(); i++)
+		{
+			if (i < first.size())
+				addresses.push_back(first[i]);
+			if (i < second.size())
+				addresses.push_back(second[i]);
+		}
+
+		return addresses;
+	}
+
 	void initialize()
 	{
 		// initializing WSA
@@ -106,7 +183,7 @@ namespace sockets
 
 	Socket::Socket() : socketId(0), timeoutSeconds(0) { }
 
-	Socket::Socket(Protocol protocol) : timeoutSeconds(2)
+	Socket::Socket(Protocol protocol, AddressFamily family) : timeoutSeconds(2)
 	{
 		int type = 0;
 
@@ -115,7 +192,7 @@ namespace sockets
 		else if (protocol == Protocol::UDP)
 			type = SOCK_DGRAM;
 
-		socketId = socket(AF_INET, type, 0);
+		socketId = socket(family == AddressFamily::IPV6 ? AF_INET6 : AF_INET, type, 0);
 
 		if (socketId == INVALID_SOCKET)
 			throw exception(WSAGetLastError());
@@ -130,19 +207,19 @@ namespace sockets
 
 	Address Socket::getSocketName() const
 	{
-		struct sockaddr_in sin {};
-		socklen_t len = sizeof(sin);
-		if (getsockname(socketId, (struct sockaddr*)&sin, &len) == -1)
+		sockaddr_storage name{};
+		socklen_t len = sizeof(name);
+		if (getsockname(socketId, (sockaddr*)&name, &len) == -1)
 			throw exception(WSAGetLastError());
 		
-		return rawAddressToAddress(sin);
+		return rawAddressToAddress(name);
 	}
 
 	void Socket::bind(Address address) const
 	{
-		sockaddr_in bindAddress = addressToRawAddress(address);
+		RawAddress bindAddress = addressToRawAddress(address);
 
-		int result = ::bind(socketId, (sockaddr*)&bindAddress, sizeof(bindAddress));
+		int result = ::bind(socketId, bindAddress.get(), bindAddress.length);
 		if (result != 0)
 			throw exception(WSAGetLastError());
 	}
@@ -157,12 +234,11 @@ namespace sockets
 	std::pair<Socket, Address> Socket::accept() const
 	{
 		// address setup
-		sockaddr_in addr;
-		memset(&addr, 0, sizeof(addr));
+		sockaddr_storage addr{};
 		socklen_t addrlen = sizeof(addr);
 
 
-		SOCKET newId = ::accept(socketId, (struct sockaddr*)&addr, &addrlen);
+		SOCKET newId = ::accept(socketId, (sockaddr*)&addr, &addrlen);
 		if (newId == INVALID_SOCKET)
 			throw exception(WSAGetLastError());
 
@@ -183,33 +259,25 @@ namespace sockets
 	void Socket::connect(Address address) const
 	{
 		setBlocking(false);
+		startConnect(address);
 
-		// starting connection
-		sockaddr_in connectAddress = addressToRawAddress(address);
-
-		int result = ::connect(socketId, (sockaddr*)&connectAddress, sizeof(connectAddress));
-		if (result != 0)
-		{
-			int error = WSAGetLastError();
-			if (error != WSAEWOULDBLOCK)
-				throw exception(error);
-		}
-
-		// using select to wait for connection to establish
-		fd_set writefds{};
+		// using select to wait for connection to establish, a failed connection is in exceptfds
+		fd_set writefds{}, exceptfds{};
 		FD_ZERO(&writefds);
 		FD_SET(socketId, &writefds);
+		FD_ZERO(&exceptfds);
+		FD_SET(socketId, &exceptfds);
 
 		struct timeval tv {};
 		tv.tv_sec = timeoutSeconds;
 		tv.tv_usec = fmodf(timeoutSeconds, 1) * 1000000;
 
-		result = select(0, NULL, &writefds, NULL, &tv);
-		if (result > 0 && FD_ISSET(socketId, &writefds))
+		int result = select((int)socketId + 1, NULL, &writefds, &exceptfds, &tv);
+		if (result > 0)
 		{
 			int so_error{};
-			int len = sizeof(so_error);
-			getsockopt(socketId, SOL_SOCKET, SO_ERROR, (char*)so_error, &len);
+			socklen_t len = sizeof(so_error);
+			getsockopt(socketId, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
 			if (so_error == 0)
 				setBlocking(true);
 			else
@@ -227,6 +295,19 @@ namespace sockets
 		}
 	}
 
+	void Socket::startConnect(Address address) const
+	{
+		RawAddress connectAddress = addressToRawAddress(address);
+
+		int result = ::connect(socketId, connectAddress.get(), connectAddress.length);
+		if (result != 0)
+		{
+			int error = WSAGetLastError();
+			if (error != WSAEWOULDBLOCK)
+				throw exception(error);
+		}
+	}
+
 	void Socket::setTimeout(float seconds)
 	{
 		timeoutSeconds = seconds;
@@ -240,6 +321,22 @@ namespace sockets
 		ioctlsocket(socketId, FIONBIO, &mode);
 	}
 
+	void Socket::setBroadcast(bool broadcast) const
+	{
+		BOOL value = broadcast;
+		if (setsockopt(socketId, SOL_SOCKET, SO_BROADCAST, (char*)&value, sizeof(value)) == SOCKET_ERROR)
+			throw exception(WSAGetLastError());
+	}
+
+	int Socket::available() const
+	{
+		unsigned long bytes = 0;
+		int result = ioctlsocket(socketId, FIONREAD, &bytes);
+		if (result == SOCKET_ERROR)
+			throw exception(WSAGetLastError());
+		return bytes;
+	}
+
 	// TCP send/recv
 	int Socket::send(const char* data, int size) const
 	{
@@ -277,9 +374,9 @@ namespace sockets
 	// UDP send/recv
 	int Socket::sendTo(const char* data, int size, Address address) const
 	{
-		sockaddr_in sendAddress = addressToRawAddress(address);
+		RawAddress sendAddress = addressToRawAddress(address);
 
-		int result = ::sendto(socketId, data, size, 0, (sockaddr*)&sendAddress, sizeof(sendAddress));
+		int result = ::sendto(socketId, data, size, 0, sendAddress.get(), sendAddress.length);
 		if (result == SOCKET_ERROR)
 			throw exception(WSAGetLastError());
 		return result;
@@ -297,8 +394,7 @@ namespace sockets
 	{
 		std::vector<char> buf(size);
 
-		sockaddr_in addr;
-		memset(&addr, 0, sizeof(addr));
+		sockaddr_storage addr{};
 		socklen_t addrlen = sizeof(addr);
 		int bytes = ::recvfrom(socketId, buf.data(), size, 0, (sockaddr*)&addr, &addrlen);
 
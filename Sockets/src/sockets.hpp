@@ -81,6 +81,15 @@ namespace sockets
 		UDP
 	};
 
+	/**
+	 * @brief An enum that represents the family of an address - IPv4 or IPv6.
+	 */
+	enum class AddressFamily
+	{
+		IPV4,
+		IPV6
+	};
+
 	/**
 	 * @brief A struct that represents an address (IP and port).
 	 */
@@ -88,6 +97,12 @@ namespace sockets
 	{
 		std::string ip;
 		unsigned short port = 0;
+
+		/**
+		 * @brief Returns the family of the IP (IPv6 IPs have colons in them).
+		 * @return The family.
+		 */
+		AddressFamily getFamily() const;
 	};
 
 	/**
@@ -98,6 +113,15 @@ namespace sockets
 	 */
 	bool operator ==(const Address& addr1, const Address& addr2);
 
+	/**
+	 * @brief Resolves a host name (or an IP) to its addresses, blocking until the lookup finishes.
+	 * The addresses are ordered for connecting (RFC 8305): the families alternate, starting with the one the system prefers.
+	 * @param host The host name or IP.
+	 * @param port The port of the addresses.
+	 * @return The addresses.
+	 */
+	std::vector<Address> resolve(const std::string& host, unsigned short port);
+
 	/**
 	 * @brief Initializes the socket library. Should be called at the start of the code.
 	 */
@@ -117,8 +141,9 @@ namespace sockets
 		/**
 		 * @brief Creates a new socket with a protocol and a timeout of 2 seconds.
 		 * @param protocol The protocol of the socket.
+		 * @param family The family of the addresses the socket uses.
 		 */
-		Socket(Protocol protocol);
+		Socket(Protocol protocol, AddressFamily family = AddressFamily::IPV4);
 
 		/**
 		 * @brief Creates a socket that can't do anything.
@@ -161,11 +186,19 @@ namespace sockets
 		void close() const;
 
 		/**
-		 * @brief Connects to an address. If the timeout is exceeded, the socket will be closed and a new one will be created.
+		 * @brief Connects to an address, blocking until it connects. If the timeout is exceeded, the socket will be closed.
+		 * To connect without blocking, or to a host name, use a Connector.
 		 * @param address The address to connect to.
 		 */
 		void connect(Address address) const;
 
+		/**
+		 * @brief Starts connecting to an address without waiting for it. The socket must be non-blocking.
+		 * It becomes writable when it connects. Throws if the connection fails right away.
+		 * @param address The address to connect to.
+		 */
+		void startConnect(Address address) const;
+
 		/**
 		 * @brief Sets the timeout of the socket.
 		 * @param seconds Timeout in seconds.
@@ -178,6 +211,18 @@ namespace sockets
 		 */
 		void setBlocking(bool blocking) const;
 
+		/**
+		 * @brief Sets whether the socket can send to broadcast addresses (UDP).
+		 * @param broadcast Whether broadcasting is allowed.
+		 */
+		void setBroadcast(bool broadcast) const;
+
+		/**
+		 * @brief Returns how many bytes can be read from the socket without blocking.
+		 * @return The number of bytes waiting in the socket.
+		 */
+		int available() const;
+
 #pragma region TCP send/recv
 		/**
 		 * @brief Sends a variable to the socket.
@@ -0,0 +1,190 @@
+#include "transport.hpp"
+#include <algorithm>
+
+namespace sockets
+{
+	int Transport::sendTo(const std::vector<char>& data, Address address) const
+	{
+		return sendTo(data.data(), (int)data.size(), address);
+	}
+
+	// UDP
+
+	UdpTransport::UdpTransport(const Socket& socket) : socket(socket) {}
+
+	int UdpTransport::sendTo(const char* data, int size, Address address) const
+	{
+		return socket.sendTo(data, size, address);
+	}
+
+	std::pair<std::vector<char>, Address> UdpTransport::recvFrom(int size) const
+	{
+		return socket.recvFrom(size);
+	}
+
+	int UdpTransport::available() const
+	{
+		return socket.available();
+	}
+
+	Address UdpTransport::getSocketName() const
+	{
+		return socket.getSocketName();
+	}
+
+	// loopback network
+
+	LoopbackNetwork::LoopbackNetwork(LinkConditions conditions, unsigned int seed) : conditions(conditions), random(seed) {}
+
+	void LoopbackNetwork::setConditions(LinkConditions newConditions)
+	{
+		std::lock_guard lock(mutex);
+		conditions = newConditions;
+	}
+
+	void LoopbackNetwork::advance(double seconds)
+	{
+		std::lock_guard lock(mutex);
+		time += seconds;
+	}
+
+	double LoopbackNetwork::getTime()
+	{
+		std::lock_guard lock(mutex);
+		return time;
+	}
+
+	std::string LoopbackNetwork::key(const Address& address)
+	{
+		return address.ip + ":" + std::to_string(address.port);
+	}
+
+	Address LoopbackNetwork::bind(Address address)
+	{
+		std::lock_guard lock(mutex);
+
+		if (address.port == 0)
+		{
+			do
+				address.port = nextPort++;
+			while (endpoints.count(key(address)) != 0);
+		}
+
+		if (endpoints.count(key(address)) != 0)
+			throw exception(WSAEADDRINUSE);
+
+		endpoints[key(address)] = Endpoint();
+		return address;
+	}
+
+	void LoopbackNetwork::unbind(const Address& address)
+	{
+		std::lock_guard lock(mutex);
+		endpoints.erase(key(address));
+	}
+
+	void LoopbackNetwork::send(const Address& from, const Address& to, std::vector<char> data)
+	{
+		std::lock_guard lock(mutex);
+
+		auto sender = endpoints.find(key(from));
+		auto receiver = endpoints.find(key(to));
+		uint64_t order = sent++;
+
+		std::uniform_real_distribution<double> chance(0, 1);
+
+		// sending takes time on a limited link, even if the datagram is lost on the way
+		double departure = time;
+		if (conditions.bandwidth > 0 && sender != endpoints.end())
+		{
+			departure = std::max(time, sender->second.busyUntil) + data.size() / conditions.bandwidth;
+			sender->second.busyUntil = departure;
+		}
+
+		// like UDP, nobody knows when a datagram is lost or has no one to receive it
+		if (receiver == endpoints.end() || chance(random) < conditions.loss)
+			return;
+
+		double arrival = departure + conditions.latency;
+		if (conditions.jitter > 0)
+			arrival += std::uniform_real_distribution<double>(-conditions.jitter, conditions.jitter)(random);
+		if (chance(random) < conditions.reorder)
+			arrival += conditions.latency;
+
+		receiver->second.incoming[{ std::max(arrival, time), order }] = { from, std::move(data) };
+	}
+
+	bool LoopbackNetwork::receive(const Address& address, Datagram& datagram)
+	{
+		std::lock_guard lock(mutex);
+
+		auto endpoint = endpoints.find(key(address));
+		if (endpoint == endpoints.end() || endpoint->second.incoming.empty())
+			return false;
+
+		auto next = endpoint->second.incoming.begin();
+		if (next->first.first > time)
+			return false;
+
+		datagram = std::move(next->second);
+		endpoint->second.incoming.erase(next);
+		return true;
+	}
+
+	int LoopbackNetwork::available(const Address& address)
+	{
+		std::lock_guard lock(mutex);
+
+		auto endpoint = endpoints.find(key(address));
+		if (endpoint == endpoints.end())
+			return 0;
+
+		int bytes = 0;
+		for (auto& [arrival, datagram] : endpoint->second.incoming)
+		{
+			if (arrival.first > time)
+				break;
+			bytes += (int)datagram.data.size();
+		}
+		return bytes;
+	}
+
+	// loopback transport
+
+	LoopbackTransport::LoopbackTransport(LoopbackNetwork& network, Address address)
+		: network(network), address(network.bind(address)) {}
+
+	LoopbackTransport::~LoopbackTransport()
+	{
+		network.unbind(address);
+	}
+
+	int LoopbackTransport::sendTo(const char* data, int size, Address to) const
+	{
+		network.send(address, to, std::vector<char>(data, data + size));
+		return size;
+	}
+
+	std::pair<std::vector<char>, Address> LoopbackTransport::recvFrom(int size) const
+	{
+		LoopbackNetwork::Datagram datagram;
+		if (!network.receive(address, datagram))
+			throw exception(WSAEWOULDBLOCK);
+
+		// like UDP, the datagram is lost if it's too big for the buffer
+		if ((int)datagram.data.size() > size)
+			throw exception(WSAEMSGSIZE);
+
+		return std::make_pair(datagram.data, datagram.from);
+	}
+
+	int LoopbackTransport::available() const
+	{
+		return network.available(address);
+	}
+
+	Address LoopbackTransport::getSocketName() const
+	{
+		return address;
+	}
+}
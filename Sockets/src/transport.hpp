@@ -0,0 +1,235 @@
+/**
+* Datagram transports: a real UDP socket, or an in-process loopback network for tests and benchmarks.
+*/
+#pragma once
+
+#include "sockets.hpp"
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace sockets
+{
+	/**
+	 * @brief Sends and receives datagrams. Works like a non-blocking UDP socket:
+	 * recvFrom throws an exception with WSAEWOULDBLOCK when there is nothing to receive.
+	 */
+	class Transport
+	{
+	public:
+		virtual ~Transport() = default;
+
+		/**
+		 * @brief Sends a datagram.
+		 * @param data The data to send.
+		 * @param size The size of the data.
+		 * @param address The address to send to.
+		 * @return The amount of bytes sent.
+		 */
+		virtual int sendTo(const char* data, int size, Address address) const = 0;
+
+		/**
+		 * @brief Receives a datagram.
+		 * @param size The maximum size of the datagram.
+		 * @return A pair with the data received, and the address it was sent from.
+		 */
+		virtual std::pair<std::vector<char>, Address> recvFrom(int size) const = 0;
+
+		/**
+		 * @brief Returns how many bytes can be received without waiting.
+		 * @return The number of bytes waiting.
+		 */
+		virtual int available() const = 0;
+
+		/**
+		 * @brief Returns the transport's own address.
+		 * @return The address.
+		 */
+		virtual Address getSocketName() const = 0;
+
+		/**
+		 * @brief Sends a datagram.
+		 * @param data The data to send.
+		 * @param address The address to send to.
+		 * @return The amount of bytes sent.
+		 */
+		int sendTo(const std::vector<char>& data, Address address) const;
+	};
+
+	/**
+	 * @brief A transport on a real UDP socket.
+	 */
+	class UdpTransport : public Transport
+	{
+	public:
+		/**
+		 * @brief Creates a new UdpTransport object.
+		 * @param socket A non-blocking UDP socket. The transport doesn't close it.
+		 */
+		UdpTransport(const Socket& socket);
+
+		int sendTo(const char* data, int size, Address address) const override;
+		std::pair<std::vector<char>, Address> recvFrom(int size) const override;
+		int available() const override;
+		Address getSocketName() const override;
+
+		using Transport::sendTo;
+
+	private:
+		Socket socket;
+	};
+
+	/**
+	 * @brief The conditions of the links of a loopback network.
+	 */
+	struct LinkConditions
+	{
+		// seconds every datagram takes to arrive
+		double latency = 0;
+		// the most seconds added to or removed from the latency of a datagram, at random
+		double jitter = 0;
+		// the chance that a datagram is lost (between 0 and 1)
+		double loss = 0;
+		// the chance that a datagram is held back by another latency, so the ones after it overtake it
+		double reorder = 0;
+		// bytes per second every sender can send, 0 for no limit
+		double bandwidth = 0;
+	};
+
+	class LoopbackTransport;
+
+	/**
+	 * @brief An in-process network of loopback transports with simulated link conditions.
+	 * Time only moves when advance is called, and the randomness comes from a seed,
+	 * so the same sends always arrive the same way.
+	 */
+	class LoopbackNetwork
+	{
+	public:
+		/**
+		 * @brief Creates a new LoopbackNetwork object.
+		 * @param conditions The conditions of every link.
+		 * @param seed The seed of the random conditions.
+		 */
+		LoopbackNetwork(LinkConditions conditions = {}, unsigned int seed = 0);
+
+		/**
+		 * @brief Changes the conditions of every link, for datagrams sent from now on.
+		 * @param conditions The conditions.
+		 */
+		void setConditions(LinkConditions conditions);
+
+		/**
+		 * @brief Moves the time of the network forward, so datagrams can arrive.
+		 * @param seconds How many seconds.
+		 */
+		void advance(double seconds);
+
+		/**
+		 * @brief Returns the time of the network.
+		 * @return Seconds since the network was created.
+		 */
+		double getTime();
+
+	private:
+		friend class LoopbackTransport;
+
+		struct Datagram
+		{
+			Address from;
+			std::vector<char> data;
+		};
+
+		struct Endpoint
+		{
+			// datagrams by (arrival time, send order)
+			std::map<std::pair<double, uint64_t>, Datagram> incoming;
+			// when the sender's link is free to send the next datagram
+			double busyUntil = 0;
+		};
+
+		/**
+		 * @brief Returns the key of an address in the endpoints.
+		 * @param address The address.
+		 * @return The key.
+		 */
+		static std::string key(const Address& address);
+
+		/**
+		 * @brief Adds an endpoint.
+		 * @param address The address, a port of 0 picks a free port.
+		 * @return The address the endpoint was bound to.
+		 */
+		Address bind(Address address);
+
+		/**
+		 * @brief Removes an endpoint, the datagrams waiting in it are lost.
+		 * @param address The address.
+		 */
+		void unbind(const Address& address);
+
+		/**
+		 * @brief Sends a datagram with the link conditions.
+		 * @param from The sender's address.
+		 * @param to The receiver's address.
+		 * @param data The datagram.
+		 */
+		void send(const Address& from, const Address& to, std::vector<char> data);
+
+		/**
+		 * @brief Pops a datagram that arrived.
+		 * @param address The receiver's address.
+		 * @param datagram Set to the datagram.
+		 * @return Whether a datagram arrived.
+		 */
+		bool receive(const Address& address, Datagram& datagram);
+
+		/**
+		 * @brief Returns the size of the next datagram that arrived.
+		 * @param address The receiver's address.
+		 * @return The size, 0 if no datagram arrived.
+		 */
+		int available(const Address& address);
+
+		std::mutex mutex;
+		LinkConditions conditions;
+		std::mt19937 random;
+		double time = 0;
+		uint64_t sent = 0;
+		unsigned short nextPort = 49152;
+		std::map<std::string, Endpoint> endpoints;
+	};
+
+	/**
+	 * @brief A transport on a loopback network.
+	 */
+	class LoopbackTransport : public Transport
+	{
+	public:
+		/**
+		 * @brief Binds a new transport to an address on a loopback network.
+		 * @param network The network, must live longer than the transport.
+		 * @param address The address, a port of 0 picks a free port.
+		 */
+		LoopbackTransport(LoopbackNetwork& network, Address address);
+
+		/**
+		 * @brief Unbinds the transport from the network.
+		 */
+		~LoopbackTransport();
+
+		LoopbackTransport(const LoopbackTransport&) = delete;
+		LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+		int sendTo(const char* data, int size, Address address) const override;
+		std::pair<std::vector<char>, Address> recvFrom(int size) const override;
+		int available() const override;
+		Address getSocketName() const override;
+
+		using Transport::sendTo;
+
+	private:
+		LoopbackNetwork& network;
+		Address address;
+	};
+}